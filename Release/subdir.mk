@@ -4,13 +4,46 @@
 
 # Add inputs and outputs from these tool invocations to the build variables
 C_SRCS += \
-../suv.c
+../suv.c \
+../suv_ingest.c \
+../suv_capture.c \
+../suv_trace.c \
+../suv_pool.c \
+../suv_select.c \
+../suv_template.c \
+../suv_poll.c \
+../suv_shm.c \
+../suv_export.c \
+../suv_fw.c \
+../suv_uring.c
 
 OBJS += \
-./suv.o
+./suv.o \
+./suv_ingest.o \
+./suv_capture.o \
+./suv_trace.o \
+./suv_pool.o \
+./suv_select.o \
+./suv_template.o \
+./suv_poll.o \
+./suv_shm.o \
+./suv_export.o \
+./suv_fw.o \
+./suv_uring.o
 
 C_DEPS += \
-./suv.d
+./suv.d \
+./suv_ingest.d \
+./suv_capture.d \
+./suv_trace.d \
+./suv_pool.d \
+./suv_select.d \
+./suv_template.d \
+./suv_poll.d \
+./suv_shm.d \
+./suv_export.d \
+./suv_fw.d \
+./suv_uring.d
 
 
 # Each subdirectory must supply rules for building sources it contributes
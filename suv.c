@@ -6,16 +6,66 @@
  */
 
 #include "suv.h"
+#include "suv_capture.h"
+#include "suv_pool.h"
+#include "suv_trace.h"
+#include "suv_uring.h"
+#include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
-static suv_write_t * suv__write_create(void);
+/* suv_write_t._flags */
+#define SUV__WRITE_PENDING 1    /* package is referenced by a libuv write */
+#define SUV__WRITE_CANCELLED 2  /* callback is called when the write is done */
+#define SUV__WRITE_NOACK 4      /* unacknowledged, not in the siridb queue */
+
+#define SUV__PKG_ALIGNED(pt__) \
+    (((uintptr_t) (pt__) & (_Alignof(siridb_pkg_t) - 1)) == 0)
+
+static suv_write_t * suv__write_create(siridb_req_t * req);
 static void suv__close_tcp(uv_handle_t * tcp);
 static void suv__write(suv_write_t * swrite);
 static void suv__alloc_buf(uv_handle_t * handle, size_t sugsz, uv_buf_t * buf);
 static void suv__on_data(uv_stream_t * clnt, ssize_t n, const uv_buf_t * buf);
+static void suv__pool_alloc_buf(
+    uv_handle_t * handle,
+    size_t sugsz,
+    uv_buf_t * buf);
+static void suv__pool_on_data(
+    uv_stream_t * clnt,
+    ssize_t n,
+    const uv_buf_t * buf);
+static int suv__read_block(suv_buf_t * suvbf, const char * pt, size_t left);
+static int suv__pkg_check(suv_buf_t * suvbf, siridb_pkg_t * pkg, size_t max);
+static void suv__on_pkg(suv_buf_t * suvbf, siridb_pkg_t * pkg);
 static void suv__write_cb(uv_write_t * uvreq, int status);
+static void suv__write_done(suv_buf_t * suvbf, uint16_t pid, int status);
+static void suv__req_cb(suv_buf_t * suvbf, siridb_req_t * req);
 static void suv__connect_cb(uv_connect_t * uvreq, int status);
+static int suv__uring_connect(suv_buf_t * suvbf, uv_stream_t * stream);
+static void suv__uring_write_pkg(suv_buf_t * suvbf, suv_write_t * swrite);
+static void suv__uring_on_data(
+    suv_buf_t * suvbf,
+    const char * data,
+    ssize_t n);
+static void suv__uring_on_sent(suv_buf_t * suvbf, uint16_t pid, int status);
+static void suv__batch_write(suv_buf_t * suvbf, suv_write_t * swrite);
+static void suv__batch_cb(uv_prepare_t * handle);
+static void suv__batch_write_cb(uv_write_t * uvreq, int status);
+static void suv__batch_close(suv_buf_t * suvbf);
+static void suv__free_handle(uv_handle_t * handle);
+static int suv__flight_add(suv_buf_t * suvbf, suv_write_t * swrite);
+static suv_write_t * suv__flight_get(suv_buf_t * suvbf, uint16_t pid);
+static int suv__flight_remove(suv_buf_t * suvbf, suv_write_t * swrite);
+static void suv__flight_cancel(suv_buf_t * suvbf);
+static void suv__noack_cb(siridb_req_t * req);
+static void suv__noack_done(
+    suv_buf_t * suvbf,
+    suv_write_t * swrite,
+    const char * msg);
+static void suv__ack_check_cb(uv_check_t * handle);
+static void suv__ack_report(suv_buf_t * suvbf);
+static void suv__ack_close(suv_buf_t * suvbf);
 
 const long int MAX_PKG_SIZE = 209715200; // can be changed to anything you want
 
@@ -41,6 +91,24 @@ suv_buf_t * suv_buf_create(siridb_t * siridb)
         suvbf->buf = NULL;
         suvbf->onclose = NULL;
         suvbf->onerror = NULL;
+        suvbf->capture = NULL;
+        suvbf->trace = NULL;
+        suvbf->pool = NULL;
+        suvbf->batch = 0;
+        suvbf->_prepare = NULL;
+        suvbf->_wpids = NULL;
+        suvbf->_wn = 0;
+        suvbf->_wsize = 0;
+        suvbf->onack = NULL;
+        memset(&suvbf->ack, 0, sizeof(suv_ack_t));
+        suvbf->_check = NULL;
+        suvbf->_noack = NULL;
+        suvbf->uring = NULL;
+        suvbf->_uconn = NULL;
+        suvbf->_rx_ts = 0;
+        suvbf->_flight = NULL;
+        suvbf->_fmask = 0;
+        suvbf->_fn = 0;
     }
     return suvbf;
 }
@@ -54,6 +122,29 @@ void suv_buf_destroy(suv_buf_t * suvbf)
     if (tcp_ != NULL)
     {
         suv_close(suvbf, NULL);
+
+        /* the handle is closed by the loop, after this buffer is gone */
+        tcp_->data = NULL;
+        suvbf->siridb->data = NULL;
+    }
+    suv__batch_close(suvbf);
+    suv__ack_close(suvbf);
+    suv__flight_cancel(suvbf);
+
+    /* unacknowledged inserts which are cancelled above are reported to
+     * onack once more, so n_sent always equals n_ok plus n_failed */
+    suv__ack_report(suvbf);
+    while (suvbf->_noack != NULL)
+    {
+        suv_write_t * swrite = suvbf->_noack;
+        suvbf->_noack = (suv_write_t *) swrite->data;
+        free(swrite);
+    }
+    free(suvbf->_flight);
+    free(suvbf->_wpids);
+    if (suvbf->pool != NULL)
+    {
+        suv_pool_release(suvbf->pool, suvbf->size);
     }
     free(suvbf->buf);
     free(suvbf);
@@ -70,11 +161,10 @@ suv_connect_t * suv_connect_create(
 {
     assert (req->data == NULL); /* req->data should be set to -this- */
 
-    suv_write_t * connect = suv__write_create();
+    suv_write_t * connect = suv__write_create(req);
     if (connect != NULL)
     {
         connect->pkg = siridb_pkg_auth(req->pid, username, password, dbname);
-        connect->_req = req;
         if (connect->pkg == NULL)
         {
             suv_write_destroy(connect);
@@ -121,6 +211,17 @@ void suv_connect(
     tcp_->data = (void *) buf;
     buf->siridb->data = (void *) tcp_;
 
+    if (buf->trace != NULL)
+    {
+        /* the connect object is created before the connection is known */
+        suv_trace_add(
+            buf->trace,
+            buf,
+            connect->_req->pid,
+            SUV_TRACE_CREATE,
+            uv_hrtime());
+    }
+
     uv_tcp_init(loop, tcp_);
 
     uvreq->data = (void *) connect->_req;
@@ -139,6 +240,13 @@ void suv_close(suv_buf_t * buf, const char * msg)
         {
             buf->onclose(buf->data, (msg == NULL) ? "connection closed" : msg);
         }
+        suv__batch_close(buf);
+        suv__ack_close(buf);
+        if (buf->_uconn != NULL)
+        {
+            suv__uring_stop(buf->_uconn);
+            buf->_uconn = NULL;
+        }
         uv_close((uv_handle_t *) tcp_, suv__close_tcp);
     }
 }
@@ -150,11 +258,10 @@ suv_query_t * suv_query_create(siridb_req_t * req, const char * query)
 {
     assert (req->data == NULL); /* req->data should be set to -this- */
 
-    suv_write_t * suvq = suv__write_create();
+    suv_write_t * suvq = suv__write_create(req);
     if (suvq != NULL)
     {
         suvq->pkg = siridb_pkg_query(req->pid, query);
-        suvq->_req = req;
         if (suvq->pkg == NULL)
         {
             suv_write_destroy(suvq);
@@ -191,11 +298,10 @@ suv_insert_t * suv_insert_create(
 {
     assert (req->data == NULL); /* req->data should be set to -this- */
 
-    suv_write_t * insert = suv__write_create();
+    suv_write_t * insert = suv__write_create(req);
     if (insert != NULL)
     {
         insert->pkg = siridb_pkg_series(req->pid, series, n);
-        insert->_req = req;
         if (insert->pkg == NULL)
         {
             suv_write_destroy(insert);
@@ -222,16 +328,137 @@ void suv_insert(suv_insert_t * insert)
     suv__write((suv_write_t *) insert);
 }
 
+typedef struct
+{
+    suv_write_t swrite;
+    siridb_req_t req;
+} suv__noack_t;
+
+/*
+ * Send an insert package without a request object. libsuv takes ownership
+ * of the package and sets the package id. The response is only checked on
+ * the package type; failures are counted in buf->ack and reported to the
+ * onack callback, at most once per loop iteration.
+ *
+ * Returns 0 if successful or ERR_SOCK_WRITE or ERR_MEM_ALLOC in which case
+ * the package is not used.
+ */
+int suv_insert_noack(suv_buf_t * buf, siridb_pkg_t * pkg)
+{
+    uv_tcp_t * tcp_ = (uv_tcp_t *) buf->siridb->data;
+    suv__noack_t * noack;
+
+    if (tcp_ == NULL || uv_is_closing((uv_handle_t *) tcp_))
+    {
+        return ERR_SOCK_WRITE;
+    }
+
+    if (buf->_check == NULL)
+    {
+        buf->_check = (uv_check_t *) malloc(sizeof(uv_check_t));
+        if (buf->_check == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+        uv_check_init(tcp_->loop, buf->_check);
+        buf->_check->data = (void *) buf;
+    }
+
+    /* write objects are kept for reuse once the response is received */
+    if (buf->_noack != NULL)
+    {
+        noack = (suv__noack_t *) buf->_noack;
+        buf->_noack = (suv_write_t *) noack->swrite.data;
+    }
+    else
+    {
+        noack = (suv__noack_t *) malloc(sizeof(suv__noack_t));
+        if (noack == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+        noack->req.data = (void *) &noack->swrite;
+        noack->req.cb = suv__noack_cb;
+        noack->req.siridb = buf->siridb;
+        noack->req.pkg = NULL;
+        noack->swrite._req = &noack->req;
+    }
+
+    noack->req.pid = buf->siridb->pid++;
+    noack->req.status = 0;
+    noack->swrite._flags = SUV__WRITE_NOACK;
+    noack->swrite.data = (void *) buf;
+    noack->swrite.pkg = pkg;
+    pkg->pid = noack->req.pid;
+
+    if (buf->trace != NULL)
+    {
+        suv_trace_add(
+            buf->trace,
+            buf,
+            noack->req.pid,
+            SUV_TRACE_CREATE,
+            uv_hrtime());
+    }
+
+    buf->ack.n_sent++;
+    suv__write(&noack->swrite);
+    return 0;
+}
+
+/*
+ * Create and return a write object for an already packed package or NULL in
+ * case of an allocation error. On success the write object takes ownership
+ * of the package and the package id is set to the request pid.
+ */
+suv_write_t * suv_write_create(siridb_req_t * req, siridb_pkg_t * pkg)
+{
+    assert (req->data == NULL); /* req->data should be set to -this- */
+
+    suv_write_t * swrite = suv__write_create(req);
+    if (swrite != NULL)
+    {
+        pkg->pid = req->pid;
+        swrite->pkg = pkg;
+    }
+    return swrite;
+}
+
+/*
+ * This function actually sends a write object. Always use the callback
+ * defined by the request object parsed to suv_write_create() for errors.
+ */
+void suv_write(suv_write_t * swrite)
+{
+    suv__write(swrite);
+}
+
 /*
  * Create and return a write object or NULL in case of an allocation error.
  */
-static suv_write_t * suv__write_create(void)
+static suv_write_t * suv__write_create(siridb_req_t * req)
 {
     suv_write_t * swrite = (suv_write_t *) malloc(sizeof(suv_write_t));
     if (swrite != NULL)
     {
         swrite->data = NULL;
         swrite->pkg = NULL;
+        swrite->_req = req;
+        swrite->_flags = 0;
+
+        /* the connection is only known when the request is created after
+         * suv_connect() */
+        uv_tcp_t * tcp_ = (uv_tcp_t *) req->siridb->data;
+        suv_buf_t * suvbf = (tcp_ == NULL) ? NULL : (suv_buf_t *) tcp_->data;
+        if (suvbf != NULL && suvbf->trace != NULL)
+        {
+            suv_trace_add(
+                suvbf->trace,
+                suvbf,
+                req->pid,
+                SUV_TRACE_CREATE,
+                uv_hrtime());
+        }
     }
     return swrite;
 }
@@ -248,6 +475,8 @@ static void suv__close_tcp(uv_handle_t * tcp)
         {
             buf->siridb->data = NULL;
         }
+        suv__flight_cancel(buf);
+        suv__ack_report(buf);
     }
     free(tcp);
 }
@@ -262,13 +491,38 @@ void suv_write_destroy(suv_write_t * swrite)
 }
 
 /*
- * Set request error and run callback
+ * Set request error and run callback. While libuv is still writing the
+ * package, the callback is called when the write has finished.
  */
 void suv_write_error(suv_write_t * swrite, int err_code)
 {
-    queue_pop(swrite->_req->siridb->queue, swrite->pkg->pid);
+    uv_tcp_t * tcp_ = (uv_tcp_t *) swrite->_req->siridb->data;
+    suv_buf_t * suvbf = (tcp_ == NULL) ? NULL : (suv_buf_t *) tcp_->data;
+
+    if (swrite->_flags & SUV__WRITE_PENDING)
+    {
+        swrite->_flags |= SUV__WRITE_CANCELLED;
+        swrite->_req->status = err_code;
+        return;
+    }
+
+    if ((suvbf == NULL || suv__flight_remove(suvbf, swrite)) &&
+        !(swrite->_flags & SUV__WRITE_NOACK))
+    {
+        /* not written yet so the request is still in the siridb queue */
+        queue_pop(swrite->_req->siridb->queue, swrite->pkg->pid);
+    }
     swrite->_req->status = err_code;
-    swrite->_req->cb(swrite->_req);
+    suv__req_cb(suvbf, swrite->_req);
+}
+
+/*
+ * Cancel a write object. The request callback is called with status
+ * ERR_CANCELLED. Can also be used to implement a timeout.
+ */
+void suv_write_cancel(suv_write_t * swrite)
+{
+    suv_write_error(swrite, ERR_CANCELLED);
 }
 
 /*
@@ -288,12 +542,25 @@ static void suv__write(suv_write_t * swrite)
     assert (swrite->_req->data == swrite); /* bind swrite to req->data */
 
     uv_stream_t * stream = (uv_stream_t *) swrite->_req->siridb->data;
-    if (stream == NULL)
+    if (stream == NULL || uv_is_closing((uv_handle_t *) stream))
     {
         suv_write_error(swrite, ERR_SOCK_WRITE);
         return;
     }
 
+    suv_buf_t * suvbf = (suv_buf_t *) stream->data;
+    if (suvbf->_uconn != NULL)
+    {
+        suv__uring_write_pkg(suvbf, swrite);
+        return;
+    }
+
+    if (suvbf->_prepare != NULL)
+    {
+        suv__batch_write(suvbf, swrite);
+        return;
+    }
+
     uv_write_t * uvreq = (uv_write_t *) malloc(sizeof(uv_write_t));
     if (uvreq == NULL)
     {
@@ -301,19 +568,54 @@ static void suv__write(suv_write_t * swrite)
         return;
     }
 
-    uvreq->data = (void *) swrite->_req;
+    int rc = suv__flight_add(suvbf, swrite);
+    if (rc)
+    {
+        free(uvreq);
+        suv_write_error(swrite, rc);
+        return;
+    }
+
+    /* the request can be cancelled before the write has finished so only
+     * the pid is bound to the libuv write request */
+    uvreq->data = (void *) (uintptr_t) swrite->pkg->pid;
+
+    if (suvbf->capture != NULL)
+    {
+        suv_capture_pkg(suvbf->capture, SUV_CAPTURE_OUT, swrite->pkg);
+    }
+
+    if (suvbf->trace != NULL)
+    {
+        suv_trace_add(
+            suvbf->trace,
+            suvbf,
+            swrite->pkg->pid,
+            SUV_TRACE_WRITE,
+            uv_hrtime());
+    }
 
     uv_buf_t buf = uv_buf_init(
         (char *) swrite->pkg,
         sizeof(siridb_pkg_t) + swrite->pkg->len);
 
-    uv_write(uvreq, stream, &buf, 1, suv__write_cb);
+    rc = uv_write(uvreq, stream, &buf, 1, suv__write_cb);
+    if (rc)
+    {
+        free(uvreq);
+        suv_write_error(swrite, -rc);
+        return;
+    }
+
+    /* the package may not be freed until suv__write_cb() is called */
+    swrite->_flags |= SUV__WRITE_PENDING;
 }
 
 static void suv__connect_cb(uv_connect_t * uvreq, int status)
 {
     siridb_req_t * req = (siridb_req_t *) uvreq->data;
     suv_connect_t * connect = (suv_connect_t *) req->data;
+    int rc;
 
     if (status != 0)
     {
@@ -323,28 +625,185 @@ static void suv__connect_cb(uv_connect_t * uvreq, int status)
     }
     else
     {
-        uv_write_t * uvw = (uv_write_t *) malloc(sizeof(uv_write_t));
-        if (uvw == NULL)
+        suv_buf_t * suvbf = (suv_buf_t *) uvreq->handle->data;
+        uv_write_t * uvw = NULL;
+
+        if (suvbf->uring != NULL)
+        {
+            rc = suv__uring_connect(suvbf, uvreq->handle);
+        }
+        else
+        {
+            uvw = (uv_write_t *) malloc(sizeof(uv_write_t));
+            rc = (uvw == NULL) ? ERR_MEM_ALLOC : 0;
+        }
+
+        if (rc || (rc = suv__flight_add(suvbf, (suv_write_t *) connect)) ||
+            (suvbf->_uconn != NULL &&
+             (rc = suv__uring_write(suvbf->_uconn, connect->pkg))))
         {
-            suv_write_error((suv_write_t *) connect, ERR_MEM_ALLOC);
+            free(uvw);
+            if (suvbf->_uconn != NULL)
+            {
+                suv__uring_stop(suvbf->_uconn);
+                suvbf->_uconn = NULL;
+            }
+            suv_write_error((suv_write_t *) connect, rc);
             uv_close(
                 (uv_handle_t *) connect->_req->siridb->data, suv__close_tcp);
         }
         else
         {
-            uvw->data = (void *) req;
+            if (suvbf->capture != NULL)
+            {
+                suv_capture_pkg(suvbf->capture, SUV_CAPTURE_OUT, connect->pkg);
+            }
+
+            if (suvbf->trace != NULL)
+            {
+                suv_trace_add(
+                    suvbf->trace,
+                    suvbf,
+                    connect->pkg->pid,
+                    SUV_TRACE_WRITE,
+                    uv_hrtime());
+            }
+
+            if (suvbf->_uconn == NULL)
+            {
+                uvw->data = (void *) (uintptr_t) connect->pkg->pid;
+
+                uv_buf_t buf = uv_buf_init(
+                        (char *) connect->pkg,
+                        sizeof(siridb_pkg_t) + connect->pkg->len);
 
-            uv_buf_t buf = uv_buf_init(
-                    (char *) connect->pkg,
-                    sizeof(siridb_pkg_t) + connect->pkg->len);
+                if (suvbf->batch && suvbf->_prepare == NULL)
+                {
+                    /* without a prepare handle writes are not batched */
+                    suvbf->_prepare =
+                            (uv_prepare_t *) malloc(sizeof(uv_prepare_t));
+                    if (suvbf->_prepare != NULL)
+                    {
+                        uv_prepare_init(uvreq->handle->loop, suvbf->_prepare);
+                        suvbf->_prepare->data = (void *) suvbf;
+                    }
+                }
 
-            uv_read_start(uvreq->handle, suv__alloc_buf, suv__on_data);
-            uv_write(uvw, uvreq->handle, &buf, 1, suv__write_cb);
+                if (suvbf->pool != NULL)
+                {
+                    uv_read_start(
+                        uvreq->handle,
+                        suv__pool_alloc_buf,
+                        suv__pool_on_data);
+                }
+                else
+                {
+                    uv_read_start(
+                        uvreq->handle,
+                        suv__alloc_buf,
+                        suv__on_data);
+                }
+                rc = uv_write(uvw, uvreq->handle, &buf, 1, suv__write_cb);
+                if (rc)
+                {
+                    free(uvw);
+                    suv_write_error((suv_write_t *) connect, -rc);
+                    uv_close(
+                        (uv_handle_t *) connect->_req->siridb->data,
+                        suv__close_tcp);
+                }
+                else
+                {
+                    /* the package may not be freed until suv__write_cb() */
+                    connect->_flags |= SUV__WRITE_PENDING;
+                }
+            }
         }
     }
     free(uvreq);
 }
 
+/*
+ * Start reading and writing a connection through io_uring instead of the
+ * libuv stream. Returns 0 if successful or an error code.
+ */
+static int suv__uring_connect(suv_buf_t * suvbf, uv_stream_t * stream)
+{
+    uv_os_fd_t fd;
+    int rc = uv_fileno((uv_handle_t *) stream, &fd);
+    if (rc)
+    {
+        return -rc;
+    }
+
+    suvbf->_uconn = suv__uring_start(
+        suvbf->uring,
+        suvbf,
+        fd,
+        suv__uring_on_data,
+        suv__uring_on_sent,
+        &rc);
+    return rc;
+}
+
+/*
+ * Write a package through io_uring. The package is copied so it is never
+ * referenced by a pending write.
+ */
+static void suv__uring_write_pkg(suv_buf_t * suvbf, suv_write_t * swrite)
+{
+    int rc = suv__flight_add(suvbf, swrite);
+    if (rc || (rc = suv__uring_write(suvbf->_uconn, swrite->pkg)))
+    {
+        suv_write_error(swrite, rc);
+        return;
+    }
+
+    if (suvbf->capture != NULL)
+    {
+        suv_capture_pkg(suvbf->capture, SUV_CAPTURE_OUT, swrite->pkg);
+    }
+
+    if (suvbf->trace != NULL)
+    {
+        suv_trace_add(
+            suvbf->trace,
+            suvbf,
+            swrite->pkg->pid,
+            SUV_TRACE_WRITE,
+            uv_hrtime());
+    }
+}
+
+static void suv__uring_on_data(
+    suv_buf_t * suvbf,
+    const char * data,
+    ssize_t n)
+{
+    if (n < 0)
+    {
+        suv_close(suvbf, (n != UV_EOF) ? uv_strerror(n) : NULL);
+    }
+    else if (suv__read_block(suvbf, data, (size_t) n))
+    {
+        suv_close(suvbf, "memory limit reached, connection closed");
+    }
+}
+
+static void suv__uring_on_sent(suv_buf_t * suvbf, uint16_t pid, int status)
+{
+    if (suvbf->trace != NULL)
+    {
+        suv_trace_add(
+            suvbf->trace,
+            suvbf,
+            pid,
+            SUV_TRACE_WRITE_DONE,
+            uv_hrtime());
+    }
+    suv__write_done(suvbf, pid, status);
+}
+
 static void suv__alloc_buf(uv_handle_t * handle, size_t sugsz, uv_buf_t * buf)
 {
     suv_buf_t * suvbf = (suv_buf_t *) handle->data;
@@ -369,7 +828,6 @@ static void suv__on_data(uv_stream_t * clnt, ssize_t n, const uv_buf_t * buf)
     suv_buf_t * suvbf = (suv_buf_t *) clnt->data;
     siridb_pkg_t * pkg;
     size_t total_sz;
-    int rc;
 
     if (n < 0)
     {
@@ -377,6 +835,11 @@ static void suv__on_data(uv_stream_t * clnt, ssize_t n, const uv_buf_t * buf)
         return;
     }
 
+    if (suvbf->trace != NULL && suvbf->len == 0 && n > 0)
+    {
+        suvbf->_rx_ts = uv_hrtime();
+    }
+
     suvbf->len += n;
 
     if (suvbf->len < sizeof(siridb_pkg_t))
@@ -385,9 +848,8 @@ static void suv__on_data(uv_stream_t * clnt, ssize_t n, const uv_buf_t * buf)
     }
 
     pkg = (siridb_pkg_t *) suvbf->buf;
-    if (!siridb_pkg_check_bit(pkg) || pkg->len > MAX_PKG_SIZE)
+    if (suv__pkg_check(suvbf, pkg, MAX_PKG_SIZE))
     {
-        suv_close(suvbf, "invalid package, connection closed");
         return;
     }
 
@@ -408,13 +870,7 @@ static void suv__on_data(uv_stream_t * clnt, ssize_t n, const uv_buf_t * buf)
         return;
     }
 
-    if ((rc = siridb_on_pkg(suvbf->siridb, pkg)))
-    {
-        if (suvbf->onerror != NULL)
-        {
-            suvbf->onerror(suvbf->data, siridb_strerror(rc));
-        }
-    }
+    suv__on_pkg(suvbf, pkg);
 
     suvbf->len -= total_sz;
 
@@ -426,19 +882,848 @@ static void suv__on_data(uv_stream_t * clnt, ssize_t n, const uv_buf_t * buf)
     }
 }
 
-static void suv__write_cb(uv_write_t * uvreq, int status)
+/*
+ * Allocate a read buffer from the pool. An idle connection does not hold a
+ * read buffer; libuv only asks for one when the socket is readable.
+ */
+static void suv__pool_alloc_buf(
+    uv_handle_t * handle,
+    size_t sugsz,
+    uv_buf_t * buf)
+{
+    suv_buf_t * suvbf = (suv_buf_t *) handle->data;
+    suv_pool_t * pool = suvbf->pool;
+    (void) sugsz;
+
+    /* libuv calls suv__pool_on_data() with UV_ENOBUFS when len is 0 */
+    buf->base = suv_pool_get(pool);
+    buf->len = (buf->base == NULL) ? 0 : pool->block_size;
+}
+
+/*
+ * Make sure the per connection buffer can hold at least size bytes. Returns
+ * 0 if successful or -1 when the per connection or pool limit is reached.
+ */
+static int suv__buf_grow(suv_buf_t * suvbf, size_t size)
 {
-    if (status)
+    suv_pool_t * pool = suvbf->pool;
+    char * tmp;
+
+    if (size <= suvbf->size)
     {
-        /* error handling */
-        siridb_req_t * req = (siridb_req_t *) uvreq->data;
-        suv_write_t * swrite = (suv_write_t *) req->data;
+        return 0;
+    }
 
-        suv_write_error(swrite, -status);
+    if (pool != NULL &&
+        (size > pool->max_conn || suv_pool_reserve(pool, size - suvbf->size)))
+    {
+        return -1;
     }
 
-    /* free uv_write_t */
-    free(uvreq);
+    tmp = (char *) realloc(suvbf->buf, size);
+    if (tmp == NULL)
+    {
+        abort(); /* memory allocation error */
+    }
+    suvbf->buf = tmp;
+    suvbf->size = size;
+    return 0;
+}
+
+/*
+ * Release the per connection buffer when it is larger than the pool allows
+ * an idle connection to keep.
+ */
+static void suv__pool_shrink(suv_buf_t * suvbf)
+{
+    if (suvbf->size > suvbf->pool->max_idle)
+    {
+        suv_pool_release(suvbf->pool, suvbf->size);
+        free(suvbf->buf);
+        suvbf->buf = NULL;
+        suvbf->size = 0;
+    }
+}
+
+/*
+ * Handle data read into a pool block. The block is returned to the pool
+ * when the read is handled.
+ */
+static void suv__pool_on_data(
+    uv_stream_t * clnt,
+    ssize_t n,
+    const uv_buf_t * buf)
+{
+    suv_buf_t * suvbf = (suv_buf_t *) clnt->data;
+    int rc;
+
+    if (n < 0)
+    {
+        suv_pool_put(suvbf->pool, buf->base);
+        suv_close(suvbf, (n == UV_ENOBUFS) ?
+                "memory limit reached, connection closed" :
+                (n != UV_EOF) ? uv_strerror(n) : NULL);
+        return;
+    }
+
+    rc = suv__read_block(suvbf, buf->base, (size_t) n);
+    suv_pool_put(suvbf->pool, buf->base);
+
+    if (rc)
+    {
+        suv_close(suvbf, "memory limit reached, connection closed");
+    }
 }
 
+/*
+ * Handle data read into a block which is not kept by the connection, like a
+ * pool block or an io_uring buffer. Complete packages are handled from the
+ * block; only an incomplete package is copied to the per connection buffer.
+ * Returns 0 if successful or -1 when the per connection or pool limit is
+ * reached.
+ */
+static int suv__read_block(suv_buf_t * suvbf, const char * pt, size_t left)
+{
+    siridb_pkg_t * pkg, hdr;
+    size_t total_sz, sz;
+
+    if (suvbf->trace != NULL && suvbf->len == 0 && left > 0)
+    {
+        suvbf->_rx_ts = uv_hrtime();
+    }
+
+    if (suvbf->len > 0)
+    {
+        /* complete the package which is kept by the connection */
+        total_sz = sizeof(siridb_pkg_t);
+        if (suvbf->len >= total_sz)
+        {
+            total_sz += ((siridb_pkg_t *) suvbf->buf)->len;
+        }
+
+        while (left)
+        {
+            sz = total_sz - suvbf->len;
+            sz = (sz > left) ? left : sz;
+            memcpy(suvbf->buf + suvbf->len, pt, sz);
+            suvbf->len += sz;
+            pt += sz;
+            left -= sz;
+
+            if (suvbf->len < total_sz)
+            {
+                break;
+            }
+
+            pkg = (siridb_pkg_t *) suvbf->buf;
+            if (total_sz == sizeof(siridb_pkg_t))
+            {
+                if (suv__pkg_check(suvbf, pkg, MAX_PKG_SIZE))
+                {
+                    return 0;
+                }
+                total_sz += pkg->len;
+                if (suv__buf_grow(suvbf, total_sz))
+                {
+                    return -1;
+                }
+                if (suvbf->len < total_sz)
+                {
+                    continue;
+                }
+                pkg = (siridb_pkg_t *) suvbf->buf;
+            }
+
+            suv__on_pkg(suvbf, pkg);
+            suvbf->len = 0;
+            if (suvbf->pool != NULL)
+            {
+                suv__pool_shrink(suvbf);
+            }
+            break;
+        }
+    }
+
+    while (left >= sizeof(siridb_pkg_t))
+    {
+        /* packages may start at any offset in the block */
+        memcpy(&hdr, pt, sizeof(siridb_pkg_t));
+        if (suv__pkg_check(suvbf, &hdr, MAX_PKG_SIZE))
+        {
+            return 0;
+        }
+
+        total_sz = sizeof(siridb_pkg_t) + hdr.len;
+        if (left < total_sz)
+        {
+            break;
+        }
+
+        if (SUV__PKG_ALIGNED(pt))
+        {
+            suv__on_pkg(suvbf, (siridb_pkg_t *) pt);
+        }
+        else
+        {
+            /* use the per connection buffer which is aligned */
+            if (suv__buf_grow(suvbf, total_sz))
+            {
+                return -1;
+            }
+            memcpy(suvbf->buf, pt, total_sz);
+            suv__on_pkg(suvbf, (siridb_pkg_t *) suvbf->buf);
+            if (suvbf->pool != NULL)
+            {
+                suv__pool_shrink(suvbf);
+            }
+        }
+        pt += total_sz;
+        left -= total_sz;
+    }
+
+    if (left)
+    {
+        /* keep the incomplete package */
+        total_sz = sizeof(siridb_pkg_t);
+        if (left >= sizeof(siridb_pkg_t))
+        {
+            memcpy(&hdr, pt, sizeof(siridb_pkg_t));
+            total_sz += hdr.len;
+        }
+        if (suv__buf_grow(suvbf, total_sz))
+        {
+            return -1;
+        }
+        memcpy(suvbf->buf, pt, left);
+        suvbf->len = left;
+    }
 
+    return 0;
+}
+
+/*
+ * Check a package header. Returns 0 if the package is valid or -1 after the
+ * connection is closed.
+ */
+static int suv__pkg_check(suv_buf_t * suvbf, siridb_pkg_t * pkg, size_t max)
+{
+    if (!siridb_pkg_check_bit(pkg) || pkg->len > max)
+    {
+        suv_close(suvbf, "invalid package, connection closed");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Handle a complete package.
+ */
+static void suv__on_pkg(suv_buf_t * suvbf, siridb_pkg_t * pkg)
+{
+    size_t total_sz = sizeof(siridb_pkg_t) + pkg->len;
+    uint16_t pid = pkg->pid;
+    suv_write_t * swrite;
+    int rc;
+
+    if (suvbf->capture != NULL)
+    {
+        suv_capture_pkg(suvbf->capture, SUV_CAPTURE_IN, pkg);
+    }
+
+    if (suvbf->trace != NULL)
+    {
+        uint64_t now = uv_hrtime();
+        suv_trace_add(
+            suvbf->trace,
+            suvbf,
+            pid,
+            SUV_TRACE_RECV_FIRST,
+            suvbf->_rx_ts ? suvbf->_rx_ts : now);
+        suv_trace_add(suvbf->trace, suvbf, pid, SUV_TRACE_RECV_LAST, now);
+
+        /* remaining data is received by the same read */
+        suvbf->_rx_ts = now;
+    }
+
+    swrite = suv__flight_get(suvbf, pid);
+
+    if (swrite != NULL && (swrite->_flags & SUV__WRITE_CANCELLED))
+    {
+        /* cancelled while the package is written, the callback is called
+         * by suv__write_done() */
+        return;
+    }
+    else if (swrite != NULL && (swrite->_flags & SUV__WRITE_NOACK))
+    {
+        suv__flight_remove(suvbf, swrite);
+
+        if (pkg->tp == CprotoResInsert)
+        {
+            suv__noack_done(suvbf, swrite, NULL);
+        }
+        else
+        {
+            /* only failures are decoded, for the sample message */
+            char msg[SUV_ACK_MSG_SZ];
+            siridb_resp_t * resp = siridb_resp_create(pkg, &rc);
+            if (resp != NULL && resp->tp == SIRIDB_RESP_TP_ERROR_MSG)
+            {
+                snprintf(msg, sizeof(msg), "%s", resp->via.error_msg);
+            }
+            else
+            {
+                snprintf(msg, sizeof(msg), "insert failed (type %u)", pkg->tp);
+            }
+            if (resp != NULL)
+            {
+                siridb_resp_destroy(resp);
+            }
+            suv__noack_done(suvbf, swrite, msg);
+        }
+    }
+    else if (swrite != NULL)
+    {
+        siridb_req_t * req = swrite->_req;
+
+        suv__flight_remove(suvbf, swrite);
+
+        req->pkg = (siridb_pkg_t *) malloc(total_sz);
+        if (req->pkg == NULL)
+        {
+            req->status = ERR_MEM_ALLOC;
+        }
+        else
+        {
+            memcpy(req->pkg, pkg, total_sz);
+            req->status = 0;
+        }
+        req->cb(req);
+    }
+    else if ((rc = siridb_on_pkg(suvbf->siridb, pkg)))
+    {
+        if (suvbf->onerror != NULL)
+        {
+            suvbf->onerror(suvbf->data, siridb_strerror(rc));
+        }
+    }
+
+    if (suvbf->trace != NULL)
+    {
+        suv_trace_add(
+            suvbf->trace,
+            suvbf,
+            pid,
+            SUV_TRACE_CB_DONE,
+            uv_hrtime());
+    }
+}
+
+static void suv__write_cb(uv_write_t * uvreq, int status)
+{
+    suv_buf_t * suvbf = (suv_buf_t *) uvreq->handle->data;
+    uint16_t pid = (uint16_t) (uintptr_t) uvreq->data;
+
+    if (suvbf != NULL)
+    {
+        if (suvbf->trace != NULL)
+        {
+            suv_trace_add(
+                suvbf->trace,
+                suvbf,
+                pid,
+                SUV_TRACE_WRITE_DONE,
+                uv_hrtime());
+        }
+
+        suv__write_done(suvbf, pid, status);
+    }
+
+    /* free uv_write_t */
+    free(uvreq);
+}
+
+/*
+ * Run the callback of a request and record when it has returned. The request
+ * may be destroyed by the callback so the pid is read before.
+ */
+static void suv__req_cb(suv_buf_t * suvbf, siridb_req_t * req)
+{
+    uint16_t pid = req->pid;
+
+    req->cb(req);
+
+    if (suvbf != NULL && suvbf->trace != NULL)
+    {
+        suv_trace_add(suvbf->trace, suvbf, pid, SUV_TRACE_CB_DONE, uv_hrtime());
+    }
+}
+
+/*
+ * Called when libuv no longer uses the package of a request. A request which
+ * is cancelled while it was written is removed and gets its callback now.
+ */
+static void suv__write_done(suv_buf_t * suvbf, uint16_t pid, int status)
+{
+    suv_write_t * swrite = suv__flight_get(suvbf, pid);
+    if (swrite == NULL)
+    {
+        return;  /* response is already handled */
+    }
+
+    swrite->_flags &= ~SUV__WRITE_PENDING;
+
+    if (swrite->_flags & SUV__WRITE_CANCELLED)
+    {
+        /* status is set by suv_write_error() */
+        suv__flight_remove(suvbf, swrite);
+        suv__req_cb(suvbf, swrite->_req);
+    }
+    else if (status)
+    {
+        suv_write_error(swrite, -status);
+    }
+}
+
+/*
+ * Requests which are written are kept in a per connection open addressing
+ * table, indexed by pid. Since pids are given out in sequence they map to
+ * consecutive slots, so finding and removing a request is O(1) regardless
+ * of the number of requests in flight. Removing uses backward shifting so
+ * no tombstones are needed.
+ *
+ * Once added, a request is removed from the siridb queue and libsuv is
+ * responsible for matching the response. Unacknowledged inserts are never
+ * in the siridb queue.
+ */
+static int suv__flight_add(suv_buf_t * suvbf, suv_write_t * swrite)
+{
+    uint16_t pid = swrite->pkg->pid;
+    size_t i;
+
+    if ((suvbf->_fn + 1) * 2 > suvbf->_fmask + 1)
+    {
+        size_t mask = suvbf->_fmask ? (suvbf->_fmask << 1) | 1 : 63;
+        suv_write_t ** flight;
+
+        if (mask > UINT16_MAX * 2 + 1)
+        {
+            return ERR_OCCUPIED;  /* all pids are in use */
+        }
+
+        flight = (suv_write_t **) calloc(mask + 1, sizeof(suv_write_t *));
+        if (flight == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+
+        for (i = 0; suvbf->_fmask && i <= suvbf->_fmask; i++)
+        {
+            suv_write_t * w = suvbf->_flight[i];
+            if (w != NULL)
+            {
+                size_t j = w->pkg->pid & mask;
+                while (flight[j] != NULL)
+                {
+                    j = (j + 1) & mask;
+                }
+                flight[j] = w;
+            }
+        }
+
+        free(suvbf->_flight);
+        suvbf->_flight = flight;
+        suvbf->_fmask = mask;
+    }
+
+    for (i = pid & suvbf->_fmask;
+         suvbf->_flight[i] != NULL;
+         i = (i + 1) & suvbf->_fmask)
+    {
+        if (suvbf->_flight[i]->pkg->pid == pid)
+        {
+            return ERR_OCCUPIED;  /* pid is reused while still in flight */
+        }
+    }
+
+    suvbf->_flight[i] = swrite;
+    suvbf->_fn++;
+
+    if (!(swrite->_flags & SUV__WRITE_NOACK))
+    {
+        queue_pop(swrite->_req->siridb->queue, pid);
+    }
+    return 0;
+}
+
+/*
+ * Return the write object in flight for a pid or NULL if not found.
+ */
+static suv_write_t * suv__flight_get(suv_buf_t * suvbf, uint16_t pid)
+{
+    if (suvbf->_fn == 0)
+    {
+        return NULL;
+    }
+
+    for (size_t i = pid & suvbf->_fmask;
+         suvbf->_flight[i] != NULL;
+         i = (i + 1) & suvbf->_fmask)
+    {
+        if (suvbf->_flight[i]->pkg->pid == pid)
+        {
+            return suvbf->_flight[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Remove a write object. Returns 0 if successful or -1 when the write
+ * object is not in flight.
+ */
+static int suv__flight_remove(suv_buf_t * suvbf, suv_write_t * swrite)
+{
+    size_t mask = suvbf->_fmask;
+    size_t i, j, k;
+
+    if (suvbf->_fn == 0)
+    {
+        return -1;
+    }
+
+    for (i = swrite->pkg->pid & mask;
+         suvbf->_flight[i] != swrite;
+         i = (i + 1) & mask)
+    {
+        if (suvbf->_flight[i] == NULL)
+        {
+            return -1;
+        }
+    }
+
+    for (j = i;;)
+    {
+        j = (j + 1) & mask;
+        if (suvbf->_flight[j] == NULL)
+        {
+            break;
+        }
+        k = suvbf->_flight[j]->pkg->pid & mask;
+        if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j))
+        {
+            suvbf->_flight[i] = suvbf->_flight[j];
+            i = j;
+        }
+    }
+
+    suvbf->_flight[i] = NULL;
+    suvbf->_fn--;
+    return 0;
+}
+
+/*
+ * Cancel all requests in flight, used when a connection is closed.
+ */
+static void suv__flight_cancel(suv_buf_t * suvbf)
+{
+    for (size_t i = 0; suvbf->_fn && i <= suvbf->_fmask; i++)
+    {
+        suv_write_t * swrite = suvbf->_flight[i];
+        if (swrite != NULL)
+        {
+            /* the connection is closed so libuv no longer writes packages */
+            suvbf->_flight[i] = NULL;
+            suvbf->_fn--;
+            if (!(swrite->_flags & SUV__WRITE_CANCELLED))
+            {
+                swrite->_req->status = ERR_CANCELLED;
+            }
+            swrite->_flags &= SUV__WRITE_NOACK;
+            suv__req_cb(suvbf, swrite->_req);
+        }
+    }
+}
+
+/*
+ * With batching enabled, packages are not written right away. Their pids are
+ * collected and all packages are written with a single uv_write() from a
+ * prepare handle, which runs once per loop iteration just before the loop
+ * waits for I/O. Packages are looked up in the in-flight table when they are
+ * written so a request which is cancelled in the mean time is skipped.
+ */
+static void suv__batch_write(suv_buf_t * suvbf, suv_write_t * swrite)
+{
+    int rc;
+
+    if (suvbf->_wn == suvbf->_wsize)
+    {
+        size_t sz = suvbf->_wsize ? suvbf->_wsize * 2 : 64;
+        uint16_t * tmp = (uint16_t *) realloc(
+                suvbf->_wpids,
+                sizeof(uint16_t) * sz);
+        if (tmp == NULL)
+        {
+            suv_write_error(swrite, ERR_MEM_ALLOC);
+            return;
+        }
+        suvbf->_wpids = tmp;
+        suvbf->_wsize = sz;
+    }
+
+    rc = suv__flight_add(suvbf, swrite);
+    if (rc)
+    {
+        suv_write_error(swrite, rc);
+        return;
+    }
+
+    if (suvbf->capture != NULL)
+    {
+        suv_capture_pkg(suvbf->capture, SUV_CAPTURE_OUT, swrite->pkg);
+    }
+
+    suvbf->_wpids[suvbf->_wn++] = swrite->pkg->pid;
+    if (suvbf->_wn == 1)
+    {
+        uv_prepare_start(suvbf->_prepare, suv__batch_cb);
+    }
+}
+
+typedef struct
+{
+    uv_write_t req;
+    size_t n;
+    uint16_t pids[];
+} suv__batch_t;
+
+static void suv__batch_cb(uv_prepare_t * handle)
+{
+    suv_buf_t * suvbf = (suv_buf_t *) handle->data;
+    uv_stream_t * stream = (uv_stream_t *) suvbf->siridb->data;
+    uint64_t now = (suvbf->trace != NULL) ? uv_hrtime() : 0;
+    suv__batch_t * batch;
+    suv_write_t * swrite;
+    uv_buf_t * bufs;
+    size_t n = 0;
+    int rc;
+
+    uv_prepare_stop(handle);
+
+    batch = (suv__batch_t *) malloc(
+            sizeof(suv__batch_t) + sizeof(uint16_t) * suvbf->_wn);
+    bufs = (uv_buf_t *) malloc(sizeof(uv_buf_t) * suvbf->_wn);
+
+    if (batch == NULL || bufs == NULL ||
+        stream == NULL || uv_is_closing((uv_handle_t *) stream))
+    {
+        int err_code = (batch == NULL || bufs == NULL) ?
+                ERR_MEM_ALLOC : ERR_SOCK_WRITE;
+        free(batch);
+        free(bufs);
+
+        /* a callback might write again so take pids from the end */
+        while (suvbf->_wn)
+        {
+            swrite = suv__flight_get(suvbf, suvbf->_wpids[--suvbf->_wn]);
+            if (swrite != NULL)
+            {
+                suv_write_error(swrite, err_code);
+            }
+        }
+        uv_prepare_stop(handle);
+        return;
+    }
+
+    for (size_t i = 0; i < suvbf->_wn; i++)
+    {
+        swrite = suv__flight_get(suvbf, suvbf->_wpids[i]);
+        if (swrite == NULL)
+        {
+            continue;  /* cancelled */
+        }
+
+        bufs[n] = uv_buf_init(
+            (char *) swrite->pkg,
+            sizeof(siridb_pkg_t) + swrite->pkg->len);
+        batch->pids[n++] = swrite->pkg->pid;
+
+        if (suvbf->trace != NULL)
+        {
+            suv_trace_add(
+                suvbf->trace,
+                suvbf,
+                swrite->pkg->pid,
+                SUV_TRACE_WRITE,
+                now);
+        }
+    }
+
+    suvbf->_wn = 0;
+    batch->n = n;
+
+    /* libuv makes a copy of the buffer array */
+    rc = (n == 0) ? 0 : uv_write(
+            &batch->req,
+            stream,
+            bufs,
+            n,
+            suv__batch_write_cb);
+    free(bufs);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        swrite = suv__flight_get(suvbf, batch->pids[i]);
+        if (rc)
+        {
+            suv_write_error(swrite, -rc);
+        }
+        else
+        {
+            /* the package may not be freed until suv__batch_write_cb() */
+            swrite->_flags |= SUV__WRITE_PENDING;
+        }
+    }
+
+    if (n == 0 || rc)
+    {
+        free(batch);
+    }
+}
+
+static void suv__batch_write_cb(uv_write_t * uvreq, int status)
+{
+    suv_buf_t * suvbf = (suv_buf_t *) uvreq->handle->data;
+    suv__batch_t * batch = (suv__batch_t *) uvreq;
+    uint64_t now = (suvbf != NULL && suvbf->trace != NULL) ? uv_hrtime() : 0;
+
+    for (size_t i = 0; suvbf != NULL && i < batch->n; i++)
+    {
+        if (suvbf->trace != NULL)
+        {
+            suv_trace_add(
+                suvbf->trace,
+                suvbf,
+                batch->pids[i],
+                SUV_TRACE_WRITE_DONE,
+                now);
+        }
+
+        suv__write_done(suvbf, batch->pids[i], status);
+    }
+
+    free(batch);
+}
+
+/*
+ * Close the prepare handle used for batching, if any. Pending packages are
+ * in the in-flight table and will be cancelled when the connection closes.
+ */
+static void suv__batch_close(suv_buf_t * suvbf)
+{
+    if (suvbf->_prepare != NULL)
+    {
+        uv_close((uv_handle_t *) suvbf->_prepare, suv__free_handle);
+        suvbf->_prepare = NULL;
+    }
+    suvbf->_wn = 0;
+}
+
+static void suv__free_handle(uv_handle_t * handle)
+{
+    free(handle);
+}
+
+/*
+ * Request callback of an unacknowledged insert, only called on an error.
+ */
+static void suv__noack_cb(siridb_req_t * req)
+{
+    suv_write_t * swrite = (suv_write_t *) req->data;
+    suv__noack_done(
+        (suv_buf_t *) swrite->data,
+        swrite,
+        suv_strerror(req->status));
+}
+
+/*
+ * Count the result of an unacknowledged insert and keep the write object
+ * for reuse. A failure message is kept as sample when it is not seen since
+ * the last report.
+ */
+static void suv__noack_done(
+    suv_buf_t * suvbf,
+    suv_write_t * swrite,
+    const char * msg)
+{
+    suv_ack_t * ack = &suvbf->ack;
+
+    free(swrite->pkg);
+    swrite->pkg = NULL;
+    swrite->data = (void *) suvbf->_noack;
+    suvbf->_noack = swrite;
+
+    if (msg == NULL)
+    {
+        ack->n_ok++;
+        return;
+    }
+
+    ack->n_failed++;
+    ack->failed++;
+
+    for (size_t i = 0; i < ack->n_msgs; i++)
+    {
+        if (strncmp(ack->msgs[i], msg, SUV_ACK_MSG_SZ - 1) == 0)
+        {
+            msg = NULL;  /* already a sample */
+            break;
+        }
+    }
+
+    if (msg != NULL && ack->n_msgs < SUV_ACK_SAMPLES)
+    {
+        snprintf(ack->msgs[ack->n_msgs++], SUV_ACK_MSG_SZ, "%s", msg);
+    }
+
+    if (suvbf->_check != NULL)
+    {
+        uv_check_start(suvbf->_check, suv__ack_check_cb);
+    }
+}
+
+static void suv__ack_check_cb(uv_check_t * handle)
+{
+    uv_check_stop(handle);
+    suv__ack_report((suv_buf_t *) handle->data);
+}
+
+/*
+ * Call the onack callback when there are failures since the last report.
+ */
+static void suv__ack_report(suv_buf_t * suvbf)
+{
+    if (suvbf->ack.failed == 0)
+    {
+        return;
+    }
+
+    if (suvbf->onack != NULL)
+    {
+        suvbf->onack(suvbf->data, &suvbf->ack);
+    }
+    suvbf->ack.failed = 0;
+    suvbf->ack.n_msgs = 0;
+}
+
+/*
+ * Close the check handle used for reporting, if any. Failures while the
+ * connection is closing are reported when the requests are cancelled.
+ */
+static void suv__ack_close(suv_buf_t * suvbf)
+{
+    if (suvbf->_check != NULL)
+    {
+        uv_close((uv_handle_t *) suvbf->_check, suv__free_handle);
+        suvbf->_check = NULL;
+    }
+}
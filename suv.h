@@ -9,8 +9,8 @@
 #define SUV_H_
 
 #define SUV_VERSION_MAJOR 0
-#define SUV_VERSION_MINOR 1
-#define SUV_VERSION_PATCH 2
+#define SUV_VERSION_MINOR 2
+#define SUV_VERSION_PATCH 0
 
 #define SUV_STRINGIFY(num) #num
 #define SUV_VERSION_STR(major,minor,patch)   \
@@ -23,6 +23,9 @@
         SUV_VERSION_MINOR,                   \
         SUV_VERSION_PATCH)
 
+#define SUV_ACK_SAMPLES 4
+#define SUV_ACK_MSG_SZ 128
+
 #include <stdlib.h>
 #include <uv.h>
 #include <libsiridb/siridb.h>
@@ -33,6 +36,11 @@ typedef struct suv_write_s suv_write_t;
 typedef struct suv_write_s suv_connect_t;
 typedef struct suv_write_s suv_query_t;
 typedef struct suv_write_s suv_insert_t;
+typedef struct suv_capture_s suv_capture_t;
+typedef struct suv_trace_s suv_trace_t;
+typedef struct suv_pool_s suv_pool_t;
+typedef struct suv_ack_s suv_ack_t;
+typedef struct suv_uring_s suv_uring_t;
 
 /* public functions */
 #ifdef __cplusplus
@@ -40,12 +48,16 @@ extern "C" {
 #endif
 
 typedef void (*suv_cb) (void * buf_data, const char * msg);
+typedef void (*suv_ack_cb) (void * buf_data, suv_ack_t * ack);
 
 suv_buf_t * suv_buf_create(siridb_t * siridb);
 void suv_buf_destroy(suv_buf_t * suvbf);
 
+suv_write_t * suv_write_create(siridb_req_t * req, siridb_pkg_t * pkg);
 void suv_write_destroy(suv_write_t * swrite);
+void suv_write(suv_write_t * swrite);
 void suv_write_error(suv_write_t * swrite, int err_code);
+void suv_write_cancel(suv_write_t * swrite);
 
 suv_connect_t * suv_connect_create(
     siridb_req_t * req,
@@ -70,6 +82,7 @@ suv_insert_t * suv_insert_create(
     size_t n);
 void suv_insert_destroy(suv_insert_t * insert);
 void suv_insert(suv_insert_t * insert);
+int suv_insert_noack(suv_buf_t * buf, siridb_pkg_t * pkg);
 
 const char * suv_strerror(int err_code);
 const char * suv_version(void);
@@ -82,15 +95,43 @@ const char * suv_version(void);
 #endif
 
 /* struct definitions */
+struct suv_ack_s
+{
+    uint64_t n_sent;        /* readonly */
+    uint64_t n_ok;          /* readonly */
+    uint64_t n_failed;      /* readonly */
+    uint64_t failed;        /* readonly, failures since the last callback */
+    size_t n_msgs;          /* readonly */
+    char msgs[SUV_ACK_SAMPLES][SUV_ACK_MSG_SZ]; /* readonly, distinct samples */
+};
+
 struct suv_buf_s
 {
     void * data;            /* public */
     suv_cb onclose;         /* public */
     suv_cb onerror;         /* public */
+    suv_capture_t * capture;/* public, see suv_capture.h */
+    suv_trace_t * trace;    /* public, see suv_trace.h */
+    suv_pool_t * pool;      /* public, see suv_pool.h */
+    int batch;              /* public, batch writes per loop iteration */
+    suv_ack_cb onack;       /* public, failures of unacknowledged inserts */
+    suv_ack_t ack;          /* readonly */
+    suv_uring_t * uring;    /* public, see suv_uring.h */
     char * buf;
     size_t len;
     size_t size;
     siridb_t * siridb;
+    uint64_t _rx_ts;
+    suv_write_t ** _flight; /* requests in flight, indexed by pid */
+    size_t _fmask;
+    size_t _fn;
+    uv_prepare_t * _prepare;
+    uint16_t * _wpids;      /* pids of packages waiting to be written */
+    size_t _wn;
+    size_t _wsize;
+    uv_check_t * _check;
+    suv_write_t * _noack;   /* recycled unacknowledged insert objects */
+    struct suv__uring_conn_s * _uconn;
 };
 
 struct suv_write_s
@@ -98,6 +139,7 @@ struct suv_write_s
     void * data;            /* public */
     siridb_pkg_t * pkg;     /* packge to send */
     siridb_req_t * _req;    /* will not be cleared */
+    int _flags;
 };
 
 #endif /* SUV_H_ */
@@ -0,0 +1,210 @@
+/*
+ * suv_capture.c - Capture SiriDB packages to a file for replay.
+ *
+ *  Records are copied into a block in memory and written by the libuv thread
+ *  pool (see suv_fw.h), so the read and write paths of a connection only pay
+ *  for a memcpy. When more than max_pending bytes are waiting to be written,
+ *  records are dropped and counted instead.
+ *
+ *  File layout:
+ *
+ *      "SUVCAP" uint16 version
+ *      record: uint64 timestamp (ns), uint8 direction, siridb_pkg_t + data
+ *
+ *  All integers are stored in host byte order.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_capture.h"
+#include "suv_fw.h"
+#include <string.h>
+#include <assert.h>
+
+#define SUV__CAPTURE_BLOCK_SIZE 4194304
+#define SUV__CAPTURE_MAX_PENDING 67108864
+
+static void suv__capture_close_cb(void * data);
+
+/*
+ * Create a capture file and return a capture object or NULL in case of an
+ * error. When rc is not NULL, it will be set to ERR_MEM_ALLOC or a
+ * (positive) libuv error code. Set suv_buf_t.capture to start capturing the
+ * packages of a connection.
+ */
+suv_capture_t * suv_capture_create(
+    uv_loop_t * loop,
+    const char * fn,
+    int * rc)
+{
+    char header[SUV_CAPTURE_HEADER_SZ];
+    uint16_t version = SUV_CAPTURE_VERSION;
+    int err;
+
+    suv_capture_t * capture = (suv_capture_t *) malloc(sizeof(suv_capture_t));
+    if (capture == NULL)
+    {
+        if (rc != NULL)
+        {
+            *rc = ERR_MEM_ALLOC;
+        }
+        return NULL;
+    }
+
+    memcpy(header, SUV_CAPTURE_MAGIC, sizeof(SUV_CAPTURE_MAGIC) - 1);
+    memcpy(header + sizeof(SUV_CAPTURE_MAGIC) - 1, &version, sizeof(uint16_t));
+
+    capture->err_code = 0;
+    capture->_fw = suv__fw_create(
+        loop,
+        fn,
+        header,
+        SUV_CAPTURE_HEADER_SZ,
+        &capture->err_code,
+        &err);
+    if (capture->_fw == NULL)
+    {
+        if (rc != NULL)
+        {
+            *rc = err;
+        }
+        free(capture);
+        return NULL;
+    }
+
+    capture->data = NULL;
+    capture->block_size = SUV__CAPTURE_BLOCK_SIZE;
+    capture->max_pending = SUV__CAPTURE_MAX_PENDING;
+    capture->n_records = 0;
+    capture->n_dropped = 0;
+    capture->_start = uv_hrtime();
+    capture->_cb = NULL;
+    capture->_closing = 0;
+
+    return capture;
+}
+
+/*
+ * Write the remaining records and close the capture file. The callback
+ * (which may be NULL) is called when the file is closed, after which the
+ * capture object is destroyed. Make sure no connection uses the capture
+ * object anymore.
+ */
+void suv_capture_close(suv_capture_t * capture, suv_capture_cb cb)
+{
+    assert (!capture->_closing);  /* close is already called */
+
+    capture->_cb = cb;
+    capture->_closing = 1;
+    suv__fw_close(capture->_fw, suv__capture_close_cb, capture);
+}
+
+/*
+ * Add a package to the capture. This function is called by libsuv for each
+ * package which is written or received on a connection with a capture.
+ */
+void suv_capture_pkg(
+    suv_capture_t * capture,
+    suv_capture_dir_t dir,
+    siridb_pkg_t * pkg)
+{
+    size_t pkgsz = sizeof(siridb_pkg_t) + pkg->len;
+    size_t sz = SUV_CAPTURE_RECORD_SZ + pkgsz;
+    uint64_t ts;
+    unsigned char * pt = suv__fw_reserve(
+        capture->_fw,
+        sz,
+        capture->block_size,
+        capture->max_pending);
+
+    if (pt == NULL)
+    {
+        capture->n_dropped++;
+        return;
+    }
+
+    ts = uv_hrtime() - capture->_start;
+
+    memcpy(pt, &ts, sizeof(uint64_t));
+    pt[sizeof(uint64_t)] = (unsigned char) dir;
+    memcpy(pt + SUV_CAPTURE_RECORD_SZ, pkg, pkgsz);
+
+    suv__fw_commit(capture->_fw, sz);
+    capture->n_records++;
+}
+
+/*
+ * Read the next record from capture file data. The offset must be 0 for the
+ * first record and will be updated to the next record.
+ *
+ * Returns 0 when a record is read, 1 at the end of the data or -1 if the
+ * data is not a valid capture.
+ */
+int suv_capture_next(
+    const unsigned char * data,
+    size_t len,
+    size_t * offset,
+    suv_capture_rec_t * rec)
+{
+    siridb_pkg_t pkg;
+    size_t pos = *offset;
+
+    if (pos == 0)
+    {
+        uint16_t version;
+        if (len < SUV_CAPTURE_HEADER_SZ ||
+            memcmp(data, SUV_CAPTURE_MAGIC, sizeof(SUV_CAPTURE_MAGIC) - 1))
+        {
+            return -1;
+        }
+        memcpy(
+            &version,
+            data + sizeof(SUV_CAPTURE_MAGIC) - 1,
+            sizeof(uint16_t));
+        if (version != SUV_CAPTURE_VERSION)
+        {
+            return -1;
+        }
+        pos = SUV_CAPTURE_HEADER_SZ;
+    }
+
+    if (pos == len)
+    {
+        *offset = pos;
+        return 1;
+    }
+
+    if (len - pos < SUV_CAPTURE_RECORD_SZ + sizeof(siridb_pkg_t))
+    {
+        return -1;
+    }
+
+    memcpy(&rec->ts, data + pos, sizeof(uint64_t));
+    rec->dir = (suv_capture_dir_t) data[pos + sizeof(uint64_t)];
+    rec->pkg = data + pos + SUV_CAPTURE_RECORD_SZ;
+
+    memcpy(&pkg, rec->pkg, sizeof(siridb_pkg_t));
+    rec->size = sizeof(siridb_pkg_t) + pkg.len;
+    rec->tp = pkg.tp;
+    rec->pid = pkg.pid;
+
+    if (len - pos - SUV_CAPTURE_RECORD_SZ < rec->size)
+    {
+        return -1;
+    }
+
+    *offset = pos + SUV_CAPTURE_RECORD_SZ + rec->size;
+    return 0;
+}
+
+static void suv__capture_close_cb(void * data)
+{
+    suv_capture_t * capture = (suv_capture_t *) data;
+
+    if (capture->_cb != NULL)
+    {
+        capture->_cb(capture);
+    }
+
+    free(capture);
+}
@@ -0,0 +1,78 @@
+/*
+ * suv_capture.h - Capture SiriDB packages to a file for replay.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_CAPTURE_H_
+#define SUV_CAPTURE_H_
+
+#include <suv.h>
+
+#define SUV_CAPTURE_MAGIC "SUVCAP"
+#define SUV_CAPTURE_VERSION 1
+
+/* size of the file header and of a record header (excluding the package) */
+#define SUV_CAPTURE_HEADER_SZ 8
+#define SUV_CAPTURE_RECORD_SZ 9
+
+/* type definitions */
+typedef enum
+{
+    SUV_CAPTURE_OUT,        /* package written to SiriDB */
+    SUV_CAPTURE_IN          /* package received from SiriDB */
+} suv_capture_dir_t;
+
+typedef struct suv_capture_rec_s suv_capture_rec_t;
+typedef void (*suv_capture_cb) (suv_capture_t * capture);
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_capture_t * suv_capture_create(
+    uv_loop_t * loop,
+    const char * fn,
+    int * rc);
+void suv_capture_close(suv_capture_t * capture, suv_capture_cb cb);
+void suv_capture_pkg(
+    suv_capture_t * capture,
+    suv_capture_dir_t dir,
+    siridb_pkg_t * pkg);
+int suv_capture_next(
+    const unsigned char * data,
+    size_t len,
+    size_t * offset,
+    suv_capture_rec_t * rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_capture_rec_s
+{
+    uint64_t ts;                /* nanoseconds since the capture started */
+    suv_capture_dir_t dir;
+    uint8_t tp;                 /* package type */
+    uint16_t pid;               /* package id */
+    size_t size;                /* package size including the header */
+    const unsigned char * pkg;  /* points into the data, may be unaligned */
+};
+
+struct suv_capture_s
+{
+    void * data;                /* public */
+    size_t block_size;          /* public, default 4MB */
+    size_t max_pending;         /* public, max bytes waiting to be written */
+    uint64_t n_records;         /* readonly */
+    uint64_t n_dropped;         /* readonly, records dropped by max_pending */
+    int err_code;               /* readonly, first write error */
+    struct suv__fw_s * _fw;
+    uint64_t _start;
+    suv_capture_cb _cb;
+    int _closing;
+};
+
+#endif /* SUV_CAPTURE_H_ */
@@ -0,0 +1,1062 @@
+/*
+ * suv_export.c - Compact binary export and parallel import of series data.
+ *
+ *  An export file is written from select responses. Each series in a
+ *  response is encoded in blocks of at most max_points points. Timestamps
+ *  and integer values are stored as zigzag varint deltas, float values as
+ *  the XOR with the previous value (see suv__xor_put()) and strings as a
+ *  varint length followed by the bytes. Blocks are written by the libuv thread
+ *  pool, like a capture file (see suv_fw.h).
+ *
+ *  The import maps the file in memory. Consecutive blocks are grouped into
+ *  insert packages of at most max_points points and packed by the libuv
+ *  thread pool, while the loop thread sends the packed packages round robin
+ *  over one or more connections.
+ *
+ *  File layout:
+ *
+ *      "SUVEXP" uint16 version
+ *      blocks
+ *      series table: for each series uint16 length, name
+ *      block table: for each block uint64 offset, uint32 size,
+ *                   uint32 series, uint32 points, uint8 type, 3 pad bytes
+ *      trailer: uint64 series table offset, uint64 block table offset,
+ *               uint32 number of series, uint32 number of blocks,
+ *               "SUVEXP" uint16 version
+ *
+ *  All integers are stored in little endian byte order.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_export.h"
+#include "suv_select.h"
+#include "suv_qp.h"
+#include "suv_fw.h"
+#include "suv_hash.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+#define SUV__EXPORT_BLOCK_SIZE 4194304
+#define SUV__EXPORT_MAX_POINTS 10000
+#define SUV__IMPORT_MAX_PENDING 64
+#define SUV__IMPORT_MAX_WORKERS 4
+#define SUV__VARINT_SZ 10
+
+struct suv__export_series_s
+{
+    char * name;
+    size_t len;
+    uint64_t hash;
+};
+
+struct suv__export_entry_s
+{
+    uint64_t offset;
+    uint32_t size;
+    uint32_t series;
+    uint32_t n;
+    uint8_t tp;
+};
+
+typedef struct
+{
+    uv_work_t work;
+    suv_import_t * imp;
+    size_t first;
+    size_t n;
+    size_t points;
+    siridb_pkg_t * pkg;
+    int rc;
+} suv__import_job_t;
+
+static int suv__export_series(
+    suv_export_t * exp,
+    suv_select_series_t * series);
+static int suv__export_get(suv_export_t * exp, const char * name);
+static void suv__export_close_cb(void * data);
+static void suv__import_next(suv_import_t * imp);
+static void suv__import_work(uv_work_t * work);
+static void suv__import_after_work(uv_work_t * work, int status);
+static void suv__import_insert_cb(siridb_req_t * req);
+static void suv__import_done(suv_import_t * imp);
+
+/*
+ * Write the n lowest bytes of u in little endian byte order.
+ */
+static inline unsigned char * suv__le_put(
+    unsigned char * pt,
+    uint64_t u,
+    size_t n)
+{
+    for (; n; n--, u >>= 8)
+    {
+        *pt++ = (unsigned char) u;
+    }
+    return pt;
+}
+
+static inline uint64_t suv__le_get(const unsigned char * pt, size_t n)
+{
+    uint64_t u = 0;
+    while (n--)
+    {
+        u = (u << 8) | pt[n];
+    }
+    return u;
+}
+
+static inline unsigned char * suv__varint_put(unsigned char * pt, uint64_t u)
+{
+    while (u >= 0x80)
+    {
+        *pt++ = (unsigned char) (u | 0x80);
+        u >>= 7;
+    }
+    *pt++ = (unsigned char) u;
+    return pt;
+}
+
+/*
+ * Read a varint. Returns NULL when the varint does not end before end.
+ */
+static inline const unsigned char * suv__varint_get(
+    const unsigned char * pt,
+    const unsigned char * end,
+    uint64_t * u)
+{
+    uint64_t v = 0;
+    for (unsigned shift = 0; pt < end && shift < 64; shift += 7)
+    {
+        v |= (uint64_t) (*pt & 0x7f) << shift;
+        if ((*pt++ & 0x80) == 0)
+        {
+            *u = v;
+            return pt;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Write the XOR of a float with the previous float. Like Gorilla, only the
+ * meaningful bits between the leading and trailing zeros are stored, but in
+ * whole bytes: a byte with the number of trailing zero bytes in the high
+ * nibble and the number of meaningful bytes in the low nibble, followed by
+ * the meaningful bytes, lowest first. An unchanged value is a single zero
+ * byte, a value which changes only the top of the mantissa a few bytes.
+ */
+static inline unsigned char * suv__xor_put(unsigned char * pt, uint64_t x)
+{
+    unsigned int tz = 0, n = 8;
+
+    if (x == 0)
+    {
+        *pt++ = 0;
+        return pt;
+    }
+
+    while ((x & 0xff) == 0)
+    {
+        x >>= 8;
+        tz++;
+    }
+    while ((x >> ((n - tz - 1) * 8)) == 0)
+    {
+        n--;
+    }
+    n -= tz;
+
+    *pt++ = (unsigned char) (tz << 4 | n);
+    return suv__le_put(pt, x, n);
+}
+
+/*
+ * Read a value written by suv__xor_put(). Returns NULL when the value is
+ * invalid or does not end before end.
+ */
+static inline const unsigned char * suv__xor_get(
+    const unsigned char * pt,
+    const unsigned char * end,
+    uint64_t * x)
+{
+    unsigned int tz, n;
+
+    if (pt == end)
+    {
+        return NULL;
+    }
+    tz = *pt >> 4;
+    n = *pt++ & 0xf;
+    if (tz + n > 8 || (n == 0 && tz) || n > (size_t) (end - pt))
+    {
+        return NULL;
+    }
+
+    *x = suv__le_get(pt, n) << (tz * 8);
+    return pt + n;
+}
+
+static inline uint64_t suv__zigzag(int64_t i)
+{
+    return ((uint64_t) i << 1) ^ (uint64_t) (i >> 63);
+}
+
+static inline int64_t suv__unzigzag(uint64_t u)
+{
+    return (int64_t) (u >> 1) ^ -(int64_t) (u & 1);
+}
+
+/*
+ * Create an export file and return an export object or NULL in case of an
+ * error. When rc is not NULL, it will be set to ERR_MEM_ALLOC or a
+ * (positive) libuv error code.
+ */
+suv_export_t * suv_export_create(uv_loop_t * loop, const char * fn, int * rc)
+{
+    unsigned char header[SUV_EXPORT_HEADER_SZ];
+    int err;
+
+    suv_export_t * exp = (suv_export_t *) malloc(sizeof(suv_export_t));
+    if (exp == NULL)
+    {
+        if (rc != NULL)
+        {
+            *rc = ERR_MEM_ALLOC;
+        }
+        return NULL;
+    }
+
+    memcpy(header, SUV_EXPORT_MAGIC, sizeof(SUV_EXPORT_MAGIC) - 1);
+    suv__le_put(
+        header + sizeof(SUV_EXPORT_MAGIC) - 1,
+        SUV_EXPORT_VERSION,
+        sizeof(uint16_t));
+
+    exp->err_code = 0;
+    exp->_fw = suv__fw_create(
+        loop,
+        fn,
+        header,
+        SUV_EXPORT_HEADER_SZ,
+        &exp->err_code,
+        &err);
+    if (exp->_fw == NULL)
+    {
+        if (rc != NULL)
+        {
+            *rc = err;
+        }
+        free(exp);
+        return NULL;
+    }
+
+    exp->data = NULL;
+    exp->block_size = SUV__EXPORT_BLOCK_SIZE;
+    exp->max_points = SUV__EXPORT_MAX_POINTS;
+    exp->n_series = 0;
+    exp->n_points = 0;
+    exp->_series = NULL;
+    exp->_sseries = 0;
+    exp->_table = NULL;
+    exp->_mask = 0;
+    exp->_entries = NULL;
+    exp->_nentries = 0;
+    exp->_sentries = 0;
+    exp->_cb = NULL;
+    exp->_closing = 0;
+
+    return exp;
+}
+
+/*
+ * Add the series of a select response package to the export. Returns 0 if
+ * successful or an error code. The package is not used after this call.
+ */
+int suv_export_add(suv_export_t * exp, siridb_pkg_t * pkg)
+{
+    suv_select_t * select;
+    int rc;
+
+    if (exp->err_code)
+    {
+        return exp->err_code;
+    }
+
+    select = suv_select_create(pkg, &rc);
+    if (select == NULL)
+    {
+        return rc;
+    }
+
+    for (size_t i = 0; i < select->n && rc == 0; i++)
+    {
+        rc = suv__export_series(exp, select->series + i);
+    }
+
+    suv_select_destroy(select);
+    return rc;
+}
+
+/*
+ * Write the remaining blocks, the series and block tables and close the
+ * export file. The callback (which may be NULL) is called when the file is
+ * closed, after which the export object is destroyed. Check err_code in the
+ * callback for write errors.
+ */
+void suv_export_close(suv_export_t * exp, suv_export_cb cb)
+{
+    assert (!exp->_closing);  /* close is already called */
+
+    uint64_t trailer[2];
+    size_t sz = SUV_EXPORT_TRAILER_SZ + exp->_nentries * SUV_EXPORT_ENTRY_SZ;
+    unsigned char * start, * pt;
+
+    exp->_cb = cb;
+    exp->_closing = 1;
+
+    for (size_t i = 0; i < exp->n_series; i++)
+    {
+        sz += sizeof(uint16_t) + exp->_series[i].len;
+    }
+
+    start = pt = suv__fw_reserve(exp->_fw, sz, exp->block_size, 0);
+    if (pt != NULL)
+    {
+        trailer[0] = suv__fw_tell(exp->_fw);
+        for (size_t i = 0; i < exp->n_series; i++)
+        {
+            size_t len = exp->_series[i].len;
+            pt = suv__le_put(pt, len, sizeof(uint16_t));
+            memcpy(pt, exp->_series[i].name, len);
+            pt += len;
+        }
+
+        trailer[1] = trailer[0] + (uint64_t) (pt - start);
+        for (size_t i = 0; i < exp->_nentries; i++)
+        {
+            suv__export_entry_t * entry = exp->_entries + i;
+            pt = suv__le_put(pt, entry->offset, sizeof(uint64_t));
+            pt = suv__le_put(pt, entry->size, sizeof(uint32_t));
+            pt = suv__le_put(pt, entry->series, sizeof(uint32_t));
+            pt = suv__le_put(pt, entry->n, sizeof(uint32_t));
+            pt = suv__le_put(pt, entry->tp, 4);  /* type and 3 pad bytes */
+        }
+
+        pt = suv__le_put(pt, trailer[0], sizeof(uint64_t));
+        pt = suv__le_put(pt, trailer[1], sizeof(uint64_t));
+        pt = suv__le_put(pt, exp->n_series, sizeof(uint32_t));
+        pt = suv__le_put(pt, exp->_nentries, sizeof(uint32_t));
+        memcpy(pt, SUV_EXPORT_MAGIC, sizeof(SUV_EXPORT_MAGIC) - 1);
+        suv__le_put(
+            pt + sizeof(SUV_EXPORT_MAGIC) - 1,
+            SUV_EXPORT_VERSION,
+            sizeof(uint16_t));
+
+        suv__fw_commit(exp->_fw, sz);
+    }
+    else if (exp->err_code == 0)
+    {
+        exp->err_code = ERR_MEM_ALLOC;
+    }
+
+    suv__fw_close(exp->_fw, suv__export_close_cb, exp);
+}
+
+/*
+ * Map an export file and return an import object or NULL in case of an
+ * error. When rc is not NULL, it will be set to ERR_MEM_ALLOC or a
+ * (positive) libuv error code. The packages are sent using the n
+ * connections in bufs[], which must be authenticated before the import is
+ * started.
+ */
+suv_import_t * suv_import_create(
+    uv_loop_t * loop,
+    const char * fn,
+    suv_buf_t * bufs[],
+    size_t n,
+    int * rc)
+{
+    uint64_t trailer[2];
+    uint32_t counts[2];
+    uint16_t version;
+    struct stat st;
+    suv_import_t * imp;
+    size_t i;
+    int fd, err = -UV_EINVAL;
+
+    assert (n > 0);
+
+    imp = (suv_import_t *) calloc(1, sizeof(suv_import_t));
+    if (imp == NULL)
+    {
+        if (rc != NULL)
+        {
+            *rc = ERR_MEM_ALLOC;
+        }
+        return NULL;
+    }
+
+    imp->max_points = SUV__EXPORT_MAX_POINTS;
+    imp->max_pending = SUV__IMPORT_MAX_PENDING;
+    imp->max_workers = SUV__IMPORT_MAX_WORKERS;
+    imp->_loop = loop;
+    imp->_nbufs = n;
+
+    fd = open(fn, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st) == -1)
+    {
+        err = -uv_translate_sys_error(errno);
+        if (fd != -1)
+        {
+            close(fd);
+        }
+        goto failed;
+    }
+
+    if ((size_t) st.st_size < SUV_EXPORT_HEADER_SZ + SUV_EXPORT_TRAILER_SZ)
+    {
+        close(fd);
+        goto failed;
+    }
+
+    imp->_size = (size_t) st.st_size;
+    imp->_map = (const unsigned char *) mmap(
+            NULL,
+            imp->_size,
+            PROT_READ,
+            MAP_PRIVATE,
+            fd,
+            0);
+    close(fd);
+    if (imp->_map == MAP_FAILED)
+    {
+        imp->_map = NULL;
+        err = -uv_translate_sys_error(errno);
+        goto failed;
+    }
+    (void) madvise((void *) imp->_map, imp->_size, MADV_WILLNEED);
+
+    const unsigned char * end = imp->_map + imp->_size;
+    const unsigned char * tr = end - SUV_EXPORT_TRAILER_SZ;
+
+    trailer[0] = suv__le_get(tr, sizeof(uint64_t));
+    trailer[1] = suv__le_get(tr + 8, sizeof(uint64_t));
+    counts[0] = (uint32_t) suv__le_get(tr + 16, sizeof(uint32_t));
+    counts[1] = (uint32_t) suv__le_get(tr + 20, sizeof(uint32_t));
+    version = (uint16_t) suv__le_get(end - sizeof(uint16_t), sizeof(uint16_t));
+
+    if (memcmp(imp->_map, SUV_EXPORT_MAGIC, sizeof(SUV_EXPORT_MAGIC) - 1) ||
+        memcmp(
+            tr + 24,
+            SUV_EXPORT_MAGIC,
+            sizeof(SUV_EXPORT_MAGIC) - 1) ||
+        version != SUV_EXPORT_VERSION ||
+        suv__le_get(
+            imp->_map + sizeof(SUV_EXPORT_MAGIC) - 1,
+            sizeof(uint16_t)) != SUV_EXPORT_VERSION ||
+        trailer[0] < SUV_EXPORT_HEADER_SZ ||
+        trailer[0] > trailer[1] ||
+        trailer[1] > (uint64_t) (tr - imp->_map) ||
+        (uint64_t) (tr - imp->_map) - trailer[1] !=
+            (uint64_t) counts[1] * SUV_EXPORT_ENTRY_SZ ||
+        trailer[1] - trailer[0] < (uint64_t) counts[0] * sizeof(uint16_t))
+    {
+        goto failed;
+    }
+
+    imp->n_series = counts[0];
+    imp->_nentries = counts[1];
+    imp->_bufs = (suv_buf_t **) malloc(sizeof(suv_buf_t *) * n);
+    imp->_names = (const unsigned char **) malloc(
+            sizeof(const unsigned char *) * (counts[0] ? counts[0] : 1));
+    imp->_mark = (uint32_t *) calloc(
+            counts[0] ? counts[0] : 1,
+            sizeof(uint32_t));
+    imp->_entries = (suv__export_entry_t *) malloc(
+            sizeof(suv__export_entry_t) * (counts[1] ? counts[1] : 1));
+
+    if (imp->_bufs == NULL || imp->_names == NULL ||
+        imp->_mark == NULL || imp->_entries == NULL)
+    {
+        err = ERR_MEM_ALLOC;
+        goto failed;
+    }
+
+    memcpy(imp->_bufs, bufs, sizeof(suv_buf_t *) * n);
+
+    /* series names are used directly from the mapped file */
+    const unsigned char * pt = imp->_map + trailer[0];
+    for (i = 0; i < imp->n_series; i++)
+    {
+        size_t len;
+        if (imp->_map + trailer[1] - pt < (ptrdiff_t) sizeof(uint16_t))
+        {
+            goto failed;
+        }
+        len = suv__le_get(pt, sizeof(uint16_t));
+        if (imp->_map + trailer[1] - pt < (ptrdiff_t) sizeof(uint16_t) + len)
+        {
+            goto failed;
+        }
+        imp->_names[i] = pt;
+        pt += sizeof(uint16_t) + len;
+    }
+
+    pt = imp->_map + trailer[1];
+    for (i = 0; i < imp->_nentries; i++, pt += SUV_EXPORT_ENTRY_SZ)
+    {
+        suv__export_entry_t * entry = imp->_entries + i;
+        entry->offset = suv__le_get(pt, sizeof(uint64_t));
+        entry->size = (uint32_t) suv__le_get(pt + 8, sizeof(uint32_t));
+        entry->series = (uint32_t) suv__le_get(pt + 12, sizeof(uint32_t));
+        entry->n = (uint32_t) suv__le_get(pt + 16, sizeof(uint32_t));
+        entry->tp = pt[20];
+        if (entry->offset < SUV_EXPORT_HEADER_SZ ||
+            entry->offset > trailer[0] ||
+            entry->size > trailer[0] - entry->offset ||
+            entry->series >= imp->n_series ||
+            entry->tp > SIRIDB_SERIES_TP_STR)
+        {
+            goto failed;
+        }
+    }
+
+    if (rc != NULL)
+    {
+        *rc = 0;
+    }
+    return imp;
+
+failed:
+    if (rc != NULL)
+    {
+        *rc = err;
+    }
+    suv_import_destroy(imp);
+    return NULL;
+}
+
+/*
+ * Destroy an import object. Do not call this function before the import
+ * callback is called.
+ */
+void suv_import_destroy(suv_import_t * imp)
+{
+    if (imp->_map != NULL)
+    {
+        munmap((void *) imp->_map, imp->_size);
+    }
+    free(imp->_bufs);
+    free(imp->_names);
+    free(imp->_mark);
+    free(imp->_entries);
+    free(imp);
+}
+
+/*
+ * Start the import. The callback is called with status 0 when all packages
+ * are handled or with an error code. Packages which are rejected by SiriDB
+ * are counted in n_failed. Returns 0 if successful or an error code.
+ */
+int suv_import_start(suv_import_t * imp, suv_import_cb cb)
+{
+    imp->_cb = cb;
+    imp->_next = 0;
+    imp->_status = 0;
+
+    suv__import_next(imp);
+
+    if (imp->_workers == 0)
+    {
+        if (imp->_status)
+        {
+            imp->_cb = NULL;
+            return imp->_status;
+        }
+        suv__import_done(imp);
+    }
+    return 0;
+}
+
+/*
+ * Encode a series in one or more blocks.
+ */
+static int suv__export_series(
+    suv_export_t * exp,
+    suv_select_series_t * series)
+{
+    int idx = suv__export_get(exp, series->name);
+    size_t i = 0;
+
+    if (idx < 0)
+    {
+        return ERR_MEM_ALLOC;
+    }
+
+    while (i < series->n)
+    {
+        size_t n = series->n - i;
+        size_t sz, j;
+        unsigned char * pt, * start;
+        uint64_t prev_ts = 0, prev_val = 0;
+
+        if (n > exp->max_points && exp->max_points)
+        {
+            n = exp->max_points;
+        }
+
+        sz = n * 2 * SUV__VARINT_SZ;
+        if (series->tp == SIRIDB_SERIES_TP_STR)
+        {
+            for (j = i; j < i + n; j++)
+            {
+                sz += strlen(series->via.str[j]);
+            }
+        }
+
+        if (exp->_nentries == exp->_sentries)
+        {
+            size_t size = exp->_sentries ? exp->_sentries * 2 : 64;
+            suv__export_entry_t * tmp = (suv__export_entry_t *) realloc(
+                    exp->_entries,
+                    sizeof(suv__export_entry_t) * size);
+            if (tmp == NULL)
+            {
+                return ERR_MEM_ALLOC;
+            }
+            exp->_entries = tmp;
+            exp->_sentries = size;
+        }
+
+        start = pt = suv__fw_reserve(exp->_fw, sz, exp->block_size, 0);
+        if (pt == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+
+        for (j = i; j < i + n; j++)
+        {
+            pt = suv__varint_put(
+                pt,
+                suv__zigzag((int64_t) (series->ts[j] - prev_ts)));
+            prev_ts = series->ts[j];
+
+            switch (series->tp)
+            {
+            case SIRIDB_SERIES_TP_INT64:
+                pt = suv__varint_put(
+                    pt,
+                    suv__zigzag((int64_t) (
+                        (uint64_t) series->via.int64[j] - prev_val)));
+                prev_val = (uint64_t) series->via.int64[j];
+                break;
+            case SIRIDB_SERIES_TP_REAL:
+            {
+                uint64_t bits;
+                memcpy(&bits, series->via.real + j, sizeof(uint64_t));
+                pt = suv__xor_put(pt, bits ^ prev_val);
+                prev_val = bits;
+                break;
+            }
+            case SIRIDB_SERIES_TP_STR:
+            {
+                size_t len = strlen(series->via.str[j]);
+                pt = suv__varint_put(pt, len);
+                memcpy(pt, series->via.str[j], len);
+                pt += len;
+                break;
+            }
+            }
+        }
+
+        suv__export_entry_t * entry = exp->_entries + exp->_nentries++;
+        entry->offset = suv__fw_tell(exp->_fw);
+        entry->size = (uint32_t) (pt - start);
+        entry->series = (uint32_t) idx;
+        entry->n = (uint32_t) n;
+        entry->tp = (uint8_t) series->tp;
+
+        suv__fw_commit(exp->_fw, entry->size);
+        exp->n_points += n;
+        i += n;
+    }
+
+    return 0;
+}
+
+/*
+ * Return the index of a series name, the series is added if it does not
+ * exist yet. Returns -1 in case of an allocation error.
+ */
+static int suv__export_get(suv_export_t * exp, const char * name)
+{
+    size_t len = strlen(name);
+    uint64_t hash = suv__hash(name, len);
+    suv__export_series_t * series;
+    size_t i;
+    uint32_t idx;
+
+    if (len > UINT16_MAX)
+    {
+        return -1;
+    }
+
+    if ((exp->n_series + 1) * 2 > exp->_mask + 1)
+    {
+        size_t mask = exp->_mask ? (exp->_mask << 1) | 1 : 63;
+        uint32_t * table = (uint32_t *) calloc(mask + 1, sizeof(uint32_t));
+        if (table == NULL)
+        {
+            return -1;
+        }
+        for (size_t n = 0; n < exp->n_series; n++)
+        {
+            size_t j = exp->_series[n].hash & mask;
+            while (table[j] != 0)
+            {
+                j = (j + 1) & mask;
+            }
+            table[j] = (uint32_t) n + 1;
+        }
+        free(exp->_table);
+        exp->_table = table;
+        exp->_mask = mask;
+    }
+
+    for (i = hash & exp->_mask;
+         (idx = exp->_table[i]) != 0;
+         i = (i + 1) & exp->_mask)
+    {
+        series = exp->_series + idx - 1;
+        if (series->hash == hash &&
+            series->len == len &&
+            memcmp(series->name, name, len) == 0)
+        {
+            return (int) idx - 1;
+        }
+    }
+
+    if (exp->n_series == exp->_sseries)
+    {
+        size_t sz = exp->_sseries ? exp->_sseries * 2 : 64;
+        suv__export_series_t * tmp = (suv__export_series_t *) realloc(
+            exp->_series,
+            sizeof(suv__export_series_t) * sz);
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        exp->_series = tmp;
+        exp->_sseries = sz;
+    }
+
+    series = exp->_series + exp->n_series;
+    series->name = strdup(name);
+    if (series->name == NULL)
+    {
+        return -1;
+    }
+    series->len = len;
+    series->hash = hash;
+
+    exp->_table[i] = (uint32_t) ++exp->n_series;
+    return (int) exp->n_series - 1;
+}
+
+static void suv__export_close_cb(void * data)
+{
+    suv_export_t * exp = (suv_export_t *) data;
+
+    if (exp->_cb != NULL)
+    {
+        exp->_cb(exp);
+    }
+
+    for (size_t i = 0; i < exp->n_series; i++)
+    {
+        free(exp->_series[i].name);
+    }
+    free(exp->_series);
+    free(exp->_table);
+    free(exp->_entries);
+    free(exp);
+}
+
+/*
+ * Queue packing jobs while there is room for more packages in flight. A job
+ * takes consecutive blocks up to max_points points, a series is used at
+ * most once in a package.
+ */
+static void suv__import_next(suv_import_t * imp)
+{
+    while (imp->_status == 0 &&
+           imp->_next < imp->_nentries &&
+           imp->_workers < imp->max_workers &&
+           imp->_workers + imp->_pending < imp->max_pending)
+    {
+        suv__import_job_t * job = (suv__import_job_t *) malloc(
+                sizeof(suv__import_job_t));
+        if (job == NULL)
+        {
+            imp->_status = ERR_MEM_ALLOC;
+            return;
+        }
+
+        job->imp = imp;
+        job->first = imp->_next;
+        job->n = 0;
+        job->points = 0;
+        job->pkg = NULL;
+        job->rc = 0;
+
+        imp->_group++;
+        while (imp->_next < imp->_nentries)
+        {
+            suv__export_entry_t * entry = imp->_entries + imp->_next;
+            if (job->n && (job->points + entry->n > imp->max_points ||
+                           imp->_mark[entry->series] == imp->_group))
+            {
+                break;
+            }
+            imp->_mark[entry->series] = imp->_group;
+            job->points += entry->n;
+            job->n++;
+            imp->_next++;
+        }
+
+        job->work.data = (void *) job;
+        int rc = uv_queue_work(
+            imp->_loop,
+            &job->work,
+            suv__import_work,
+            suv__import_after_work);
+        if (rc)
+        {
+            free(job);
+            imp->_status = -rc;
+            return;
+        }
+        imp->_workers++;
+    }
+}
+
+/*
+ * Pack the blocks of a job into an insert package. Runs in the thread pool
+ * and only reads the mapped file and the entries.
+ */
+static void suv__import_work(uv_work_t * work)
+{
+    suv__import_job_t * job = (suv__import_job_t *) work->data;
+    suv_import_t * imp = job->imp;
+    suv__qp_t qp = {NULL, 0, 0};
+    int close_map;
+
+    if (suv__qp_init_pkg(&qp) || suv__qp_reserve(&qp, 9))
+    {
+        job->rc = ERR_MEM_ALLOC;
+        return;
+    }
+
+    close_map = suv__qp_add_map(&qp, job->n);
+
+    for (size_t b = job->first; b < job->first + job->n; b++)
+    {
+        suv__export_entry_t * entry = imp->_entries + b;
+        const unsigned char * pt = imp->_map + entry->offset;
+        const unsigned char * end = pt + entry->size;
+        const unsigned char * name = imp->_names[entry->series];
+        uint64_t ts = 0, val = 0, u;
+        size_t len = suv__le_get(name, sizeof(uint16_t));
+
+        if (suv__qp_add_raw(
+                &qp,
+                (const char *) name + sizeof(uint16_t),
+                len) ||
+            suv__qp_reserve(&qp, 9))
+        {
+            job->rc = ERR_MEM_ALLOC;
+            break;
+        }
+
+        int close_arr = suv__qp_add_array(&qp, entry->n);
+
+        for (uint32_t i = 0; i < entry->n; i++)
+        {
+            if ((pt = suv__varint_get(pt, end, &u)) == NULL)
+            {
+                break;
+            }
+            ts += (uint64_t) suv__unzigzag(u);
+
+            if (suv__qp_reserve(&qp, 19))
+            {
+                job->rc = ERR_MEM_ALLOC;
+                break;
+            }
+            suv__qp_add_type(&qp, SUV__QP_ARRAY0 + 2);
+            suv__qp_add_int64(&qp, (int64_t) ts);
+
+            pt = (entry->tp == SIRIDB_SERIES_TP_REAL) ?
+                    suv__xor_get(pt, end, &u) :
+                    suv__varint_get(pt, end, &u);
+            if (pt == NULL)
+            {
+                break;
+            }
+
+            if (entry->tp == SIRIDB_SERIES_TP_INT64)
+            {
+                val += (uint64_t) suv__unzigzag(u);
+                suv__qp_add_int64(&qp, (int64_t) val);
+            }
+            else if (entry->tp == SIRIDB_SERIES_TP_REAL)
+            {
+                double d;
+                val ^= u;
+                memcpy(&d, &val, sizeof(double));
+                suv__qp_add_double(&qp, d);
+            }
+            else if (u > (uint64_t) (end - pt))
+            {
+                pt = NULL;
+                break;
+            }
+            else if (suv__qp_add_raw(&qp, (const char *) pt, (size_t) u))
+            {
+                job->rc = ERR_MEM_ALLOC;
+                break;
+            }
+            else
+            {
+                pt += u;
+            }
+        }
+
+        if (job->rc)
+        {
+            break;
+        }
+
+        if (pt != end)
+        {
+            job->rc = -UV_EINVAL;  /* the block is corrupt */
+            break;
+        }
+
+        if (close_arr)
+        {
+            suv__qp_add_type(&qp, SUV__QP_ARRAY_CLOSE);
+        }
+    }
+
+    if (job->rc == 0 && close_map)
+    {
+        if (suv__qp_reserve(&qp, 1))
+        {
+            job->rc = ERR_MEM_ALLOC;
+        }
+        else
+        {
+            suv__qp_add_type(&qp, SUV__QP_MAP_CLOSE);
+        }
+    }
+
+    if (job->rc)
+    {
+        free(qp.data);
+        return;
+    }
+
+    job->pkg = suv__qp_to_pkg(&qp, CprotoReqInsert);
+}
+
+static void suv__import_after_work(uv_work_t * work, int status)
+{
+    suv__import_job_t * job = (suv__import_job_t *) work->data;
+    suv_import_t * imp = job->imp;
+    siridb_req_t * req = NULL;
+    suv_insert_t * insert = NULL;
+    suv_buf_t * buf;
+    int rc = status ? -status : job->rc;
+
+    imp->_workers--;
+
+    if (rc == 0)
+    {
+        buf = imp->_bufs[imp->_idx];
+        imp->_idx = (imp->_idx + 1) % imp->_nbufs;
+
+        req = siridb_req_create(buf->siridb, suv__import_insert_cb, &rc);
+        if (req != NULL &&
+            (insert = suv_write_create(req, job->pkg)) == NULL)
+        {
+            rc = ERR_MEM_ALLOC;
+            siridb_req_destroy(req);
+        }
+    }
+
+    if (rc)
+    {
+        free(job->pkg);
+        if (imp->_status == 0)
+        {
+            imp->_status = rc;
+        }
+    }
+    else
+    {
+        req->data = (void *) insert;
+        insert->data = (void *) imp;
+        imp->_pending++;
+        imp->n_packages++;
+        imp->n_points += job->points;
+        suv_insert(insert);
+    }
+
+    free(job);
+
+    suv__import_next(imp);
+    suv__import_done(imp);
+}
+
+static void suv__import_insert_cb(siridb_req_t * req)
+{
+    suv_insert_t * insert = (suv_insert_t *) req->data;
+    suv_import_t * imp = (suv_import_t *) insert->data;
+
+    if (req->status != 0 || req->pkg->tp != CprotoResInsert)
+    {
+        imp->n_failed++;
+    }
+
+    suv_insert_destroy(insert);
+    siridb_req_destroy(req);
+
+    imp->_pending--;
+
+    suv__import_next(imp);
+    suv__import_done(imp);
+}
+
+/*
+ * Call the import callback once all blocks are sent, or an error occurred,
+ * and all packages are handled.
+ */
+static void suv__import_done(suv_import_t * imp)
+{
+    if ((imp->_next == imp->_nentries || imp->_status) &&
+        imp->_workers == 0 &&
+        imp->_pending == 0 &&
+        imp->_cb != NULL)
+    {
+        suv_import_cb cb = imp->_cb;
+        imp->_cb = NULL;
+        cb(imp, imp->_status);
+    }
+}
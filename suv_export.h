@@ -0,0 +1,100 @@
+/*
+ * suv_export.h - Compact binary export and parallel import of series data.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_EXPORT_H_
+#define SUV_EXPORT_H_
+
+#include <suv.h>
+
+#define SUV_EXPORT_MAGIC "SUVEXP"
+#define SUV_EXPORT_VERSION 1
+
+/* size of the file header, a block table entry and the trailer */
+#define SUV_EXPORT_HEADER_SZ 8
+#define SUV_EXPORT_ENTRY_SZ 24
+#define SUV_EXPORT_TRAILER_SZ 32
+
+/* type definitions */
+typedef struct suv_export_s suv_export_t;
+typedef struct suv_import_s suv_import_t;
+typedef struct suv__export_series_s suv__export_series_t;
+typedef struct suv__export_entry_s suv__export_entry_t;
+
+typedef void (*suv_export_cb) (suv_export_t * exp);
+typedef void (*suv_import_cb) (suv_import_t * imp, int status);
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_export_t * suv_export_create(uv_loop_t * loop, const char * fn, int * rc);
+int suv_export_add(suv_export_t * exp, siridb_pkg_t * pkg);
+void suv_export_close(suv_export_t * exp, suv_export_cb cb);
+
+suv_import_t * suv_import_create(
+    uv_loop_t * loop,
+    const char * fn,
+    suv_buf_t * bufs[],
+    size_t n,
+    int * rc);
+void suv_import_destroy(suv_import_t * imp);
+int suv_import_start(suv_import_t * imp, suv_import_cb cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_export_s
+{
+    void * data;                /* public */
+    size_t block_size;          /* public, default 4MB */
+    size_t max_points;          /* public, points per series block */
+    uint64_t n_series;          /* readonly */
+    uint64_t n_points;          /* readonly */
+    int err_code;               /* readonly, first write error */
+    struct suv__fw_s * _fw;
+    suv__export_series_t * _series;
+    size_t _sseries;
+    uint32_t * _table;
+    size_t _mask;
+    suv__export_entry_t * _entries;
+    size_t _nentries;
+    size_t _sentries;
+    suv_export_cb _cb;
+    int _closing;
+};
+
+struct suv_import_s
+{
+    void * data;                /* public */
+    size_t max_points;          /* public, points per package */
+    size_t max_pending;         /* public, packages in flight */
+    size_t max_workers;         /* public, packages packed in parallel */
+    uint64_t n_series;          /* readonly */
+    uint64_t n_points;          /* readonly, points sent */
+    uint64_t n_packages;        /* readonly */
+    uint64_t n_failed;          /* readonly */
+    uv_loop_t * _loop;
+    suv_buf_t ** _bufs;
+    size_t _nbufs;
+    size_t _idx;
+    const unsigned char * _map;
+    size_t _size;
+    const unsigned char ** _names;
+    suv__export_entry_t * _entries;
+    size_t _nentries;
+    size_t _next;
+    uint32_t * _mark;
+    uint32_t _group;
+    size_t _workers;
+    size_t _pending;
+    int _status;
+    suv_import_cb _cb;
+};
+
+#endif /* SUV_EXPORT_H_ */
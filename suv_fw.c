@@ -0,0 +1,242 @@
+/*
+ * suv_fw.c - Private block file writer used by libsuv.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_fw.h"
+#include <fcntl.h>
+
+static int suv__fw_write(suv__fw_block_t * block);
+static void suv__fw_write_cb(uv_fs_t * req);
+static void suv__fw_destroy(suv__fw_t * fw);
+
+/*
+ * Create a file, write the header and return a writer or NULL in which case
+ * rc is set to ERR_MEM_ALLOC or a (positive) libuv error code. Write errors
+ * are stored in err_code, which should be 0.
+ */
+suv__fw_t * suv__fw_create(
+    uv_loop_t * loop,
+    const char * fn,
+    const void * header,
+    size_t header_sz,
+    int * err_code,
+    int * rc)
+{
+    uv_fs_t req;
+    uv_buf_t buf;
+    int fd, n;
+
+    suv__fw_t * fw = (suv__fw_t *) malloc(sizeof(suv__fw_t));
+    if (fw == NULL)
+    {
+        *rc = ERR_MEM_ALLOC;
+        return NULL;
+    }
+
+    fd = uv_fs_open(loop, &req, fn, O_WRONLY | O_CREAT | O_TRUNC, 0644, NULL);
+    uv_fs_req_cleanup(&req);
+    if (fd < 0)
+    {
+        *rc = -fd;
+        free(fw);
+        return NULL;
+    }
+
+    buf = uv_buf_init((char *) header, header_sz);
+
+    n = uv_fs_write(loop, &req, fd, &buf, 1, 0, NULL);
+    uv_fs_req_cleanup(&req);
+    if (n < 0 || (size_t) n != header_sz)
+    {
+        *rc = (n < 0) ? -n : -UV_EIO;
+        uv_fs_close(loop, &req, fd, NULL);
+        uv_fs_req_cleanup(&req);
+        free(fw);
+        return NULL;
+    }
+
+    fw->loop = loop;
+    fw->fd = fd;
+    fw->offset = (int64_t) header_sz;
+    fw->pending = 0;
+    fw->nwrites = 0;
+    fw->err_code = err_code;
+    fw->block = NULL;
+    fw->cb = NULL;
+    fw->data = NULL;
+    fw->closing = 0;
+
+    *rc = 0;
+    return fw;
+}
+
+/*
+ * Return a pointer to at least sz free bytes in the current block. The
+ * current block is submitted when it is too small. A new block has at
+ * least block_size bytes. Returns NULL in case of an allocation error or
+ * when max_pending (if not 0) bytes would be exceeded.
+ */
+unsigned char * suv__fw_reserve(
+    suv__fw_t * fw,
+    size_t sz,
+    size_t block_size,
+    size_t max_pending)
+{
+    suv__fw_block_t * block = fw->block;
+
+    if (block != NULL && block->len + sz > block->size)
+    {
+        suv__fw_submit(fw);
+        block = NULL;
+    }
+
+    if (block == NULL)
+    {
+        size_t size = (sz > block_size) ? sz : block_size;
+        if ((max_pending && fw->pending + size > max_pending) ||
+            (block = (suv__fw_block_t *) malloc(
+                sizeof(suv__fw_block_t) + size)) == NULL)
+        {
+            return NULL;
+        }
+        block->fw = fw;
+        block->done = 0;
+        block->len = 0;
+        block->size = size;
+        fw->block = block;
+        fw->pending += size;
+    }
+
+    return block->data + block->len;
+}
+
+/*
+ * Hand the current block to the thread pool.
+ */
+void suv__fw_submit(suv__fw_t * fw)
+{
+    suv__fw_block_t * block = fw->block;
+    int rc;
+
+    if (block == NULL)
+    {
+        return;
+    }
+
+    fw->block = NULL;
+
+    if (block->len == 0 || *fw->err_code)
+    {
+        fw->pending -= block->size;
+        free(block);
+        return;
+    }
+
+    block->offset = fw->offset;
+    fw->offset += block->len;
+
+    rc = suv__fw_write(block);
+    if (rc)
+    {
+        *fw->err_code = -rc;
+        fw->pending -= block->size;
+        free(block);
+        return;
+    }
+
+    fw->nwrites++;
+}
+
+/*
+ * Submit the current block and close the file when all blocks are written.
+ * The callback (which may be NULL) is called with data after the file is
+ * closed, after which the writer is destroyed.
+ */
+void suv__fw_close(suv__fw_t * fw, suv__fw_cb cb, void * data)
+{
+    fw->cb = cb;
+    fw->data = data;
+    fw->closing = 1;
+
+    suv__fw_submit(fw);
+
+    if (fw->nwrites == 0)
+    {
+        suv__fw_destroy(fw);
+    }
+}
+
+static int suv__fw_write(suv__fw_block_t * block)
+{
+    uv_buf_t buf = uv_buf_init(
+        (char *) block->data + block->done,
+        block->len - block->done);
+
+    block->req.data = (void *) block;
+
+    return uv_fs_write(
+        block->fw->loop,
+        &block->req,
+        block->fw->fd,
+        &buf,
+        1,
+        block->offset,
+        suv__fw_write_cb);
+}
+
+static void suv__fw_write_cb(uv_fs_t * req)
+{
+    suv__fw_block_t * block = (suv__fw_block_t *) req->data;
+    suv__fw_t * fw = block->fw;
+    ssize_t result = req->result;
+    int rc = 0;
+
+    uv_fs_req_cleanup(req);
+
+    if (result > 0 && block->done + (size_t) result < block->len)
+    {
+        /* short write, write the remaining bytes */
+        block->done += (size_t) result;
+        block->offset += result;
+        if ((rc = suv__fw_write(block)) == 0)
+        {
+            return;
+        }
+    }
+    else if (result <= 0)
+    {
+        rc = (result < 0) ? (int) result : UV_EIO;
+    }
+
+    if (rc && *fw->err_code == 0)
+    {
+        *fw->err_code = -rc;
+    }
+
+    fw->pending -= block->size;
+    fw->nwrites--;
+    free(block);
+
+    if (fw->closing && fw->nwrites == 0)
+    {
+        suv__fw_destroy(fw);
+    }
+}
+
+static void suv__fw_destroy(suv__fw_t * fw)
+{
+    uv_fs_t req;
+
+    free(fw->block);
+
+    uv_fs_close(fw->loop, &req, fw->fd, NULL);
+    uv_fs_req_cleanup(&req);
+
+    if (fw->cb != NULL)
+    {
+        fw->cb(fw->data);
+    }
+    free(fw);
+}
@@ -0,0 +1,83 @@
+/*
+ * suv_fw.h - Private block file writer used by libsuv.
+ *
+ *  Data is copied into a memory block and full blocks are written by the
+ *  libuv thread pool at their own file offset, so the caller only pays for
+ *  a memcpy. Since libuv callbacks run on a single thread no locking is
+ *  required. A short write is resubmitted for the remaining bytes.
+ *
+ *  This header is not installed.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_FW_H_
+#define SUV_FW_H_
+
+#include <suv.h>
+
+/* type definitions */
+typedef struct suv__fw_s suv__fw_t;
+typedef struct suv__fw_block_s suv__fw_block_t;
+typedef void (*suv__fw_cb) (void * data);
+
+/* private functions */
+suv__fw_t * suv__fw_create(
+    uv_loop_t * loop,
+    const char * fn,
+    const void * header,
+    size_t header_sz,
+    int * err_code,
+    int * rc);
+unsigned char * suv__fw_reserve(
+    suv__fw_t * fw,
+    size_t sz,
+    size_t block_size,
+    size_t max_pending);
+void suv__fw_submit(suv__fw_t * fw);
+void suv__fw_close(suv__fw_t * fw, suv__fw_cb cb, void * data);
+
+/* struct definitions */
+struct suv__fw_block_s
+{
+    uv_fs_t req;
+    suv__fw_t * fw;
+    int64_t offset;             /* file offset of the next byte to write */
+    size_t done;                /* bytes written */
+    size_t len;                 /* bytes in use */
+    size_t size;
+    unsigned char data[];
+};
+
+struct suv__fw_s
+{
+    uv_loop_t * loop;
+    uv_file fd;
+    int64_t offset;             /* file offset of the current block */
+    size_t pending;             /* size of the blocks in memory */
+    size_t nwrites;
+    int * err_code;             /* first error, owned by the caller */
+    suv__fw_block_t * block;    /* current block or NULL */
+    suv__fw_cb cb;
+    void * data;
+    int closing;
+};
+
+/*
+ * Bytes reserved with suv__fw_reserve() are added to the block using this
+ * function.
+ */
+static inline void suv__fw_commit(suv__fw_t * fw, size_t sz)
+{
+    fw->block->len += sz;
+}
+
+/*
+ * Return the file offset of the next byte which is added.
+ */
+static inline uint64_t suv__fw_tell(suv__fw_t * fw)
+{
+    return (uint64_t) fw->offset + ((fw->block == NULL) ? 0 : fw->block->len);
+}
+
+#endif /* SUV_FW_H_ */
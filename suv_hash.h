@@ -0,0 +1,29 @@
+/*
+ * suv_hash.h - Private string hash used by libsuv.
+ *
+ *  FNV-1a, used to find series names in the open addressing tables of
+ *  ingest and export.
+ *
+ *  This header is not installed.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_HASH_H_
+#define SUV_HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+static inline uint64_t suv__hash(const char * name, size_t len)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char) name[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+#endif /* SUV_HASH_H_ */
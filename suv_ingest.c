@@ -0,0 +1,993 @@
+/*
+ * suv_ingest.c - Stream CSV or Graphite plaintext into SiriDB inserts.
+ *
+ *  Points are grouped per series name using a hash table and packed directly
+ *  into insert packages once max_points is reached. Packages are sent round
+ *  robin over the connections without waiting for the response, so parsing
+ *  the next chunk overlaps with sending the previous package.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_ingest.h"
+#include "suv_qp.h"
+#include "suv_hash.h"
+#include <string.h>
+#include <assert.h>
+
+#define SUV__INGEST_READ_SZ 1048576
+#define SUV__INGEST_DEFAULT_MAX_POINTS 10000
+#define SUV__INGEST_DEFAULT_MAX_PENDING 64
+
+struct suv__ingest_series_s
+{
+    char * name;
+    size_t len;
+    uint64_t hash;
+    siridb_series_tp tp;
+    siridb_point_t * points;
+    size_t n;
+    size_t size;
+};
+
+static int suv__ingest_line(
+    suv_ingest_t * ingest,
+    const char * pt,
+    const char * end);
+static int suv__ingest_add(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    siridb_series_tp tp,
+    siridb_via_t * via);
+static suv__ingest_series_t * suv__ingest_get(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len);
+static int suv__ingest_carry(
+    suv_ingest_t * ingest,
+    const char * data,
+    size_t len);
+static int suv__ingest_read(suv_ingest_t * ingest);
+static void suv__ingest_read_cb(uv_fs_t * fsreq);
+static void suv__ingest_insert_cb(siridb_req_t * req);
+static void suv__ingest_done(suv_ingest_t * ingest);
+
+static const double suv__ingest_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * Create and return an ingest object or NULL in case of an allocation error.
+ * The connections in bufs[] must be connected and authenticated before
+ * packages are flushed. Argument n must be at least 1.
+ */
+suv_ingest_t * suv_ingest_create(suv_buf_t * bufs[], size_t n)
+{
+    assert (n > 0);
+
+    suv_ingest_t * ingest = (suv_ingest_t *) calloc(1, sizeof(suv_ingest_t));
+    if (ingest != NULL)
+    {
+        ingest->fmt = SUV_INGEST_FMT_GRAPHITE;
+        ingest->max_points = SUV__INGEST_DEFAULT_MAX_POINTS;
+        ingest->max_pending = SUV__INGEST_DEFAULT_MAX_PENDING;
+        ingest->ts_multiplier = 1;
+        ingest->_bufs = (suv_buf_t **) malloc(sizeof(suv_buf_t *) * n);
+        ingest->_nbufs = n;
+        ingest->_mask = 1023;
+        ingest->_table = (uint32_t *) calloc(
+            ingest->_mask + 1,
+            sizeof(uint32_t));
+        if (ingest->_bufs == NULL || ingest->_table == NULL)
+        {
+            suv_ingest_destroy(ingest);
+            return NULL;
+        }
+        memcpy(ingest->_bufs, bufs, sizeof(suv_buf_t *) * n);
+    }
+    return ingest;
+}
+
+/*
+ * Destroy an ingest object. Points which are not flushed are lost. Do not
+ * call this function while packages are pending or a file is being read.
+ */
+void suv_ingest_destroy(suv_ingest_t * ingest)
+{
+    for (size_t i = 0; i < ingest->_nseries; i++)
+    {
+        free(ingest->_series[i].name);
+        free(ingest->_series[i].points);
+    }
+    free(ingest->_series);
+    free(ingest->_table);
+    free(ingest->_dirty);
+    free(ingest->_carry);
+    free(ingest->_rbuf[0]);
+    free(ingest->_rbuf[1]);
+    free(ingest->_bufs);
+    free(ingest);
+}
+
+/*
+ * Add an integer point. The value is converted when the series is a float
+ * series. Returns 0 if successful or an error code.
+ */
+int suv_ingest_add_int64(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    int64_t val)
+{
+    siridb_via_t via;
+    via.int64 = val;
+    return suv__ingest_add(ingest, name, len, ts, SIRIDB_SERIES_TP_INT64, &via);
+}
+
+/*
+ * Add a float point. An integer series is promoted to a float series until
+ * the next flush, including the points which are not flushed yet. Returns 0
+ * if successful or an error code.
+ */
+int suv_ingest_add_real(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    double val)
+{
+    siridb_via_t via;
+    via.real = val;
+    return suv__ingest_add(ingest, name, len, ts, SIRIDB_SERIES_TP_REAL, &via);
+}
+
+/*
+ * Parse a chunk of text. Lines may be split over chunks; an incomplete last
+ * line is kept until the next call. Call this function with len 0 to mark
+ * the end of the input. Invalid lines are counted and skipped.
+ *
+ * Returns 0 if successful or ERR_MEM_ALLOC.
+ */
+int suv_ingest_parse(suv_ingest_t * ingest, const char * data, size_t len)
+{
+    const char * pt = data;
+    const char * end = data + len;
+    const char * nl;
+    int rc;
+
+    assert (ingest->ts_multiplier > 0);
+
+    if (len == 0)
+    {
+        rc = 0;
+        if (ingest->_ncarry)
+        {
+            rc = suv__ingest_line(
+                ingest,
+                ingest->_carry,
+                ingest->_carry + ingest->_ncarry);
+            ingest->_ncarry = 0;
+        }
+        return rc;
+    }
+
+    if (ingest->_ncarry)
+    {
+        nl = (const char *) memchr(pt, '\n', len);
+        if (nl == NULL)
+        {
+            return suv__ingest_carry(ingest, pt, len);
+        }
+        if (suv__ingest_carry(ingest, pt, nl - pt))
+        {
+            return ERR_MEM_ALLOC;
+        }
+        rc = suv__ingest_line(
+            ingest,
+            ingest->_carry,
+            ingest->_carry + ingest->_ncarry);
+        ingest->_ncarry = 0;
+        if (rc)
+        {
+            return rc;
+        }
+        pt = nl + 1;
+    }
+
+    while ((nl = (const char *) memchr(pt, '\n', end - pt)) != NULL)
+    {
+        if ((rc = suv__ingest_line(ingest, pt, nl)))
+        {
+            return rc;
+        }
+        pt = nl + 1;
+    }
+
+    return (pt < end) ? suv__ingest_carry(ingest, pt, end - pt) : 0;
+}
+
+/*
+ * Pack all pending points into one insert package and send the package
+ * using the next connection. The response is handled by libsuv.
+ *
+ * Returns 0 if successful or a siridb error code. Points are kept in case of
+ * an error.
+ */
+int suv_ingest_flush(suv_ingest_t * ingest)
+{
+    suv__qp_t qp = {NULL, 0, 0};
+    suv_buf_t * buf;
+    siridb_req_t * req;
+    suv_insert_t * insert;
+    int rc = 0;
+
+    if (ingest->_ndirty == 0)
+    {
+        return 0;
+    }
+
+    if (suv__qp_init_pkg(&qp) || suv__qp_reserve(&qp, 2))
+    {
+        free(qp.data);
+        return ERR_MEM_ALLOC;
+    }
+
+    int close_map = suv__qp_add_map(&qp, ingest->_ndirty);
+
+    for (size_t i = 0; i < ingest->_ndirty; i++)
+    {
+        suv__ingest_series_t * series = ingest->_series + ingest->_dirty[i];
+
+        /* array header + per point 1 array, 9 timestamp and 9 value bytes */
+        if (suv__qp_add_raw(&qp, series->name, series->len) ||
+            suv__qp_reserve(&qp, 20 + series->n * 19))
+        {
+            free(qp.data);
+            return ERR_MEM_ALLOC;
+        }
+
+        int close_arr = suv__qp_add_array(&qp, series->n);
+        siridb_point_t * point = series->points;
+        siridb_point_t * end = point + series->n;
+
+        if (series->tp == SIRIDB_SERIES_TP_INT64)
+        {
+            for (; point < end; point++)
+            {
+                suv__qp_add_type(&qp, SUV__QP_ARRAY0 + 2);
+                suv__qp_add_int64(&qp, (int64_t) point->ts);
+                suv__qp_add_int64(&qp, point->via.int64);
+            }
+        }
+        else
+        {
+            for (; point < end; point++)
+            {
+                suv__qp_add_type(&qp, SUV__QP_ARRAY0 + 2);
+                suv__qp_add_int64(&qp, (int64_t) point->ts);
+                suv__qp_add_double(&qp, point->via.real);
+            }
+        }
+
+        if (close_arr)
+        {
+            suv__qp_add_type(&qp, SUV__QP_ARRAY_CLOSE);
+        }
+    }
+
+    if (close_map)
+    {
+        suv__qp_add_type(&qp, SUV__QP_MAP_CLOSE);
+    }
+
+    buf = ingest->_bufs[ingest->_next++ % ingest->_nbufs];
+    req = siridb_req_create(buf->siridb, suv__ingest_insert_cb, &rc);
+    if (req == NULL)
+    {
+        free(qp.data);
+        return rc ? rc : ERR_MEM_ALLOC;
+    }
+
+    insert = suv_write_create(req, suv__qp_to_pkg(&qp, CprotoReqInsert));
+    if (insert == NULL)
+    {
+        free(qp.data);
+        siridb_req_destroy(req);
+        return ERR_MEM_ALLOC;
+    }
+
+    for (size_t i = 0; i < ingest->_ndirty; i++)
+    {
+        /* the type is set again by the first point of the next package */
+        ingest->_series[ingest->_dirty[i]].n = 0;
+        ingest->_series[ingest->_dirty[i]].tp = SIRIDB_SERIES_TP_STR;
+    }
+    ingest->_ndirty = 0;
+    ingest->_npoints = 0;
+
+    insert->data = (void *) ingest;
+    req->data = (void *) insert;
+
+    ingest->_pending++;
+    ingest->n_packages++;
+
+    suv_insert(insert);
+    return 0;
+}
+
+/*
+ * Read and ingest a file descriptor (for example 0 for stdin) until the end
+ * of the file. Reads are done by the libuv thread pool so the next chunk is
+ * read while the current chunk is parsed. Reading pauses while max_pending
+ * packages are in flight.
+ *
+ * The callback is called once all packages are handled. The status is 0 if
+ * successful, ERR_MEM_ALLOC or a (positive) libuv error code.
+ */
+int suv_ingest_fd(
+    suv_ingest_t * ingest,
+    uv_loop_t * loop,
+    uv_file fd,
+    suv_ingest_cb cb)
+{
+    assert (ingest->_cb == NULL);  /* already reading a file */
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (ingest->_rbuf[i] == NULL)
+        {
+            ingest->_rbuf[i] = (char *) malloc(SUV__INGEST_READ_SZ);
+            if (ingest->_rbuf[i] == NULL)
+            {
+                return ERR_MEM_ALLOC;
+            }
+        }
+    }
+
+    ingest->_cb = cb;
+    ingest->_loop = loop;
+    ingest->_fd = fd;
+    ingest->_eof = 0;
+    ingest->_paused = 0;
+    ingest->_status = 0;
+
+    return suv__ingest_read(ingest);
+}
+
+static int suv__ingest_read(suv_ingest_t * ingest)
+{
+    uv_buf_t buf = uv_buf_init(
+        ingest->_rbuf[ingest->_ridx],
+        SUV__INGEST_READ_SZ);
+    int rc;
+
+    ingest->_fsreq.data = (void *) ingest;
+    rc = uv_fs_read(
+        ingest->_loop,
+        &ingest->_fsreq,
+        ingest->_fd,
+        &buf,
+        1,
+        -1,
+        suv__ingest_read_cb);
+    if (rc)
+    {
+        return -rc;
+    }
+    ingest->_reading = 1;
+    return 0;
+}
+
+static void suv__ingest_read_cb(uv_fs_t * fsreq)
+{
+    suv_ingest_t * ingest = (suv_ingest_t *) fsreq->data;
+    ssize_t n = fsreq->result;
+    char * chunk;
+    int rc;
+
+    uv_fs_req_cleanup(fsreq);
+    ingest->_reading = 0;
+
+    if (ingest->_eof)
+    {
+        /* stopped because of an earlier error */
+        suv__ingest_done(ingest);
+        return;
+    }
+
+    if (n <= 0)
+    {
+        if (n < 0)
+        {
+            ingest->_status = (int) -n;
+        }
+        else if ((rc = suv_ingest_parse(ingest, NULL, 0)) ||
+                 (rc = suv_ingest_flush(ingest)))
+        {
+            ingest->_status = rc;
+        }
+        ingest->_eof = 1;
+        suv__ingest_done(ingest);
+        return;
+    }
+
+    chunk = ingest->_rbuf[ingest->_ridx];
+    ingest->_ridx ^= 1;
+
+    /* start reading the next chunk before parsing this one */
+    if (ingest->_pending < ingest->max_pending)
+    {
+        if ((rc = suv__ingest_read(ingest)))
+        {
+            ingest->_status = rc;
+            ingest->_eof = 1;
+        }
+    }
+    else
+    {
+        ingest->_paused = 1;
+    }
+
+    if ((rc = suv_ingest_parse(ingest, chunk, (size_t) n)))
+    {
+        ingest->_status = rc;
+        ingest->_paused = 0;
+        ingest->_eof = 1;
+    }
+
+    suv__ingest_done(ingest);
+}
+
+static void suv__ingest_insert_cb(siridb_req_t * req)
+{
+    suv_insert_t * insert = (suv_insert_t *) req->data;
+    suv_ingest_t * ingest = (suv_ingest_t *) insert->data;
+
+    if (req->status != 0 || req->pkg->tp != CprotoResInsert)
+    {
+        ingest->n_failed++;
+    }
+
+    suv_insert_destroy(insert);
+    siridb_req_destroy(req);
+
+    ingest->_pending--;
+
+    if (ingest->_paused &&
+        !ingest->_eof &&
+        ingest->_pending < ingest->max_pending)
+    {
+        int rc;
+        ingest->_paused = 0;
+        if ((rc = suv__ingest_read(ingest)))
+        {
+            ingest->_status = rc;
+            ingest->_eof = 1;
+        }
+    }
+
+    suv__ingest_done(ingest);
+}
+
+/*
+ * Call the ingest callback once the input is finished and all packages are
+ * handled.
+ */
+static void suv__ingest_done(suv_ingest_t * ingest)
+{
+    if (ingest->_eof &&
+        !ingest->_reading &&
+        ingest->_pending == 0 &&
+        ingest->_cb != NULL)
+    {
+        suv_ingest_cb cb = ingest->_cb;
+        ingest->_cb = NULL;
+        cb(ingest, ingest->_status);
+    }
+}
+
+static int suv__ingest_carry(
+    suv_ingest_t * ingest,
+    const char * data,
+    size_t len)
+{
+    size_t sz = ingest->_ncarry + len;
+    if (sz > ingest->_scarry)
+    {
+        char * tmp = (char *) realloc(ingest->_carry, sz);
+        if (tmp == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+        ingest->_carry = tmp;
+        ingest->_scarry = sz;
+    }
+    memcpy(ingest->_carry + ingest->_ncarry, data, len);
+    ingest->_ncarry = sz;
+    return 0;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/*
+ * Check and convert eight ASCII digits at once (SWAR). The chunk is loaded
+ * as a little endian integer so the first digit is the lowest byte.
+ */
+static inline int suv__ingest_is_8digits(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+            == 0x3333333333333333ULL;
+}
+
+static inline uint64_t suv__ingest_8digits(uint64_t chunk)
+{
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) *
+              (1 + (10000ULL << 32)))) >> 32;
+    return chunk;
+}
+#endif
+
+/*
+ * Parse unsigned digits. Returns a pointer to the first non-digit or NULL
+ * when no digits are found or the number has more than 19 digits.
+ */
+static inline const char * suv__ingest_digits(
+    const char * pt,
+    const char * end,
+    uint64_t * u,
+    size_t * ndigits)
+{
+    const char * start = pt;
+    uint64_t v = 0;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (end - pt >= 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, pt, sizeof(uint64_t));
+        if (!suv__ingest_is_8digits(chunk))
+        {
+            break;
+        }
+        v = v * 100000000 + suv__ingest_8digits(chunk);
+        pt += 8;
+    }
+#endif
+
+    while (pt < end && (unsigned char) (*pt - '0') < 10)
+    {
+        v = v * 10 + (uint64_t) (*pt - '0');
+        pt++;
+    }
+
+    *ndigits = pt - start;
+    if (*ndigits == 0 || *ndigits > 19)
+    {
+        return NULL;
+    }
+    *u = v;
+    return pt;
+}
+
+/*
+ * Parse a value. Integers are returned as SIRIDB_SERIES_TP_INT64, all other
+ * numbers as SIRIDB_SERIES_TP_REAL. Returns -1 if the value is invalid.
+ */
+static int suv__ingest_value(
+    const char * pt,
+    const char * end,
+    siridb_series_tp * tp,
+    siridb_via_t * via)
+{
+    const char * start = pt;
+    uint64_t mant = 0, frac = 0;
+    size_t nint = 0, nfrac = 0, nexp;
+    int neg = 0, exp10 = 0;
+
+    if (pt < end && (*pt == '-' || *pt == '+'))
+    {
+        neg = *pt == '-';
+        pt++;
+    }
+
+    if (pt < end && *pt != '.')
+    {
+        if ((pt = suv__ingest_digits(pt, end, &mant, &nint)) == NULL)
+        {
+            goto slow;
+        }
+    }
+
+    if (pt == end)
+    {
+        if (nint == 0 || mant > (uint64_t) INT64_MAX + neg)
+        {
+            return -1;
+        }
+        *tp = SIRIDB_SERIES_TP_INT64;
+        via->int64 = neg ? (int64_t) (0 - mant) : (int64_t) mant;
+        return 0;
+    }
+
+    if (*pt == '.')
+    {
+        pt++;
+        if (pt < end && (unsigned char) (*pt - '0') < 10)
+        {
+            if ((pt = suv__ingest_digits(pt, end, &frac, &nfrac)) == NULL)
+            {
+                goto slow;
+            }
+        }
+    }
+
+    if (nint + nfrac == 0)
+    {
+        return -1;
+    }
+
+    if (pt < end && (*pt == 'e' || *pt == 'E'))
+    {
+        uint64_t e;
+        int eneg = 0;
+        pt++;
+        if (pt < end && (*pt == '-' || *pt == '+'))
+        {
+            eneg = *pt == '-';
+            pt++;
+        }
+        if ((pt = suv__ingest_digits(pt, end, &e, &nexp)) == NULL ||
+            e > 400)
+        {
+            goto slow;
+        }
+        exp10 = eneg ? -(int) e : (int) e;
+    }
+
+    if (pt != end)
+    {
+        return -1;
+    }
+
+    /* fast path, exact when the mantissa and power of ten fit a double */
+    if (nint + nfrac <= 15 && exp10 - (int) nfrac >= -22 &&
+        exp10 - (int) nfrac <= 22)
+    {
+        double d;
+        int e = exp10 - (int) nfrac;
+        mant = mant * (uint64_t) suv__ingest_pow10[nfrac] + frac;
+        d = (double) mant;
+        d = (e < 0) ? d / suv__ingest_pow10[-e] : d * suv__ingest_pow10[e];
+        *tp = SIRIDB_SERIES_TP_REAL;
+        via->real = neg ? -d : d;
+        return 0;
+    }
+
+slow:
+    {
+        char tmp[64];
+        char * tend;
+        size_t n = end - start;
+        if (n >= sizeof(tmp))
+        {
+            return -1;
+        }
+        memcpy(tmp, start, n);
+        tmp[n] = '\0';
+        via->real = strtod(tmp, &tend);
+        if (tend != tmp + n)
+        {
+            return -1;
+        }
+        *tp = SIRIDB_SERIES_TP_REAL;
+        return 0;
+    }
+}
+
+/*
+ * Return the end of a field.
+ */
+static inline const char * suv__ingest_field(
+    suv_ingest_fmt_t fmt,
+    const char * pt,
+    const char * end)
+{
+    if (fmt == SUV_INGEST_FMT_CSV)
+    {
+        const char * sep = (const char *) memchr(pt, ',', end - pt);
+        return (sep == NULL) ? end : sep;
+    }
+    while (pt < end && *pt != ' ' && *pt != '\t')
+    {
+        pt++;
+    }
+    return pt;
+}
+
+/*
+ * Skip the separator after a field.
+ */
+static inline const char * suv__ingest_skip(
+    suv_ingest_fmt_t fmt,
+    const char * pt,
+    const char * end)
+{
+    if (fmt == SUV_INGEST_FMT_CSV)
+    {
+        return (pt < end) ? pt + 1 : pt;
+    }
+    while (pt < end && (*pt == ' ' || *pt == '\t'))
+    {
+        pt++;
+    }
+    return pt;
+}
+
+/*
+ * Parse a single line without the newline character. Returns 0 or
+ * ERR_MEM_ALLOC, invalid lines are counted and skipped.
+ */
+static int suv__ingest_line(
+    suv_ingest_t * ingest,
+    const char * pt,
+    const char * end)
+{
+    suv_ingest_fmt_t fmt = ingest->fmt;
+    const char * name;
+    const char * field;
+    size_t len, ndigits;
+    uint64_t ts = 0;
+    siridb_series_tp tp;
+    siridb_via_t via;
+
+    if (end > pt && end[-1] == '\r')
+    {
+        end--;
+    }
+
+    if (pt == end || *pt == '#')
+    {
+        return 0;  /* empty lines and comments are allowed */
+    }
+
+    ingest->n_lines++;
+
+    if (fmt == SUV_INGEST_FMT_CSV && *pt == '"')
+    {
+        /* quoted names are used as-is, embedded quotes are not supported */
+        name = ++pt;
+        field = (const char *) memchr(pt, '"', end - pt);
+        if (field == NULL || field + 1 == end || field[1] != ',')
+        {
+            goto invalid;
+        }
+        len = field - name;
+        pt = field + 1;
+    }
+    else
+    {
+        name = pt;
+        pt = suv__ingest_field(fmt, pt, end);
+        len = pt - name;
+    }
+
+    pt = suv__ingest_skip(fmt, pt, end);
+    field = suv__ingest_field(fmt, pt, end);
+
+    if (fmt == SUV_INGEST_FMT_CSV)
+    {
+        if (len == 0 ||
+            suv__ingest_digits(pt, field, &ts, &ndigits) != field ||
+            ts > INT64_MAX)
+        {
+            goto invalid;
+        }
+        pt = suv__ingest_skip(fmt, field, end);
+    }
+
+    while (end > pt && (end[-1] == ' ' || end[-1] == '\t'))
+    {
+        end--;
+    }
+
+    if (fmt == SUV_INGEST_FMT_CSV)
+    {
+        if (suv__ingest_value(pt, end, &tp, &via))
+        {
+            goto invalid;
+        }
+    }
+    else
+    {
+        /* Graphite plaintext has the value before the timestamp */
+        if (len == 0 || field >= end || suv__ingest_value(pt, field, &tp, &via))
+        {
+            goto invalid;
+        }
+        /* Graphite timestamps are in seconds */
+        pt = suv__ingest_skip(fmt, field, end);
+        if (suv__ingest_digits(pt, end, &ts, &ndigits) != end ||
+            ts > INT64_MAX / ingest->ts_multiplier)
+        {
+            goto invalid;
+        }
+        ts *= ingest->ts_multiplier;
+    }
+
+    return suv__ingest_add(ingest, name, len, ts, tp, &via);
+
+invalid:
+    ingest->n_invalid++;
+    return 0;
+}
+
+/*
+ * Return the series for a name, the series is created if it does not exist
+ * yet. Returns NULL in case of an allocation error.
+ */
+static suv__ingest_series_t * suv__ingest_get(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len)
+{
+    uint64_t hash = suv__hash(name, len);
+    size_t i = hash & ingest->_mask;
+    suv__ingest_series_t * series;
+    uint32_t idx;
+
+    while ((idx = ingest->_table[i]) != 0)
+    {
+        series = ingest->_series + idx - 1;
+        if (series->hash == hash &&
+            series->len == len &&
+            memcmp(series->name, name, len) == 0)
+        {
+            return series;
+        }
+        i = (i + 1) & ingest->_mask;
+    }
+
+    if ((ingest->_nseries + 1) * 2 > ingest->_mask + 1)
+    {
+        /* grow the table, the series array is not moved */
+        size_t mask = (ingest->_mask << 1) | 1;
+        uint32_t * table = (uint32_t *) calloc(mask + 1, sizeof(uint32_t));
+        if (table == NULL)
+        {
+            return NULL;
+        }
+        for (size_t n = 0; n < ingest->_nseries; n++)
+        {
+            size_t j = ingest->_series[n].hash & mask;
+            while (table[j] != 0)
+            {
+                j = (j + 1) & mask;
+            }
+            table[j] = (uint32_t) n + 1;
+        }
+        free(ingest->_table);
+        ingest->_table = table;
+        ingest->_mask = mask;
+
+        i = hash & mask;
+        while (table[i] != 0)
+        {
+            i = (i + 1) & mask;
+        }
+    }
+
+    if (ingest->_nseries == ingest->_sseries)
+    {
+        size_t sz = ingest->_sseries ? ingest->_sseries * 2 : 64;
+        suv__ingest_series_t * tmp = (suv__ingest_series_t *) realloc(
+            ingest->_series,
+            sizeof(suv__ingest_series_t) * sz);
+        if (tmp == NULL)
+        {
+            return NULL;
+        }
+        ingest->_series = tmp;
+
+        uint32_t * dirty = (uint32_t *) realloc(
+            ingest->_dirty,
+            sizeof(uint32_t) * sz);
+        if (dirty == NULL)
+        {
+            return NULL;
+        }
+        ingest->_dirty = dirty;
+        ingest->_sseries = sz;
+    }
+
+    series = ingest->_series + ingest->_nseries;
+    series->name = (char *) malloc(len + 1);
+    if (series->name == NULL)
+    {
+        return NULL;
+    }
+    memcpy(series->name, name, len);
+    series->name[len] = '\0';
+    series->len = len;
+    series->hash = hash;
+    series->points = NULL;
+    series->n = 0;
+    series->size = 0;
+    series->tp = SIRIDB_SERIES_TP_STR;  /* set by the first point */
+
+    ingest->_table[i] = (uint32_t) ++ingest->_nseries;
+    return series;
+}
+
+static int suv__ingest_add(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    siridb_series_tp tp,
+    siridb_via_t * via)
+{
+    suv__ingest_series_t * series = suv__ingest_get(ingest, name, len);
+    siridb_point_t * point;
+
+    if (series == NULL)
+    {
+        return ERR_MEM_ALLOC;
+    }
+
+    if (series->tp != tp)
+    {
+        if (series->tp == SIRIDB_SERIES_TP_STR)
+        {
+            series->tp = tp;
+        }
+        else if (series->tp == SIRIDB_SERIES_TP_REAL)
+        {
+            via->real = (double) via->int64;
+        }
+        else
+        {
+            /* an integer series gets a float, for example 100 and 99.5 */
+            for (size_t i = 0; i < series->n; i++)
+            {
+                point = series->points + i;
+                point->via.real = (double) point->via.int64;
+            }
+            series->tp = SIRIDB_SERIES_TP_REAL;
+        }
+    }
+
+    if (series->n == series->size)
+    {
+        size_t sz = series->size ? series->size * 2 : 16;
+        point = (siridb_point_t *) realloc(
+            series->points,
+            sizeof(siridb_point_t) * sz);
+        if (point == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+        series->points = point;
+        series->size = sz;
+    }
+
+    if (series->n == 0)
+    {
+        ingest->_dirty[ingest->_ndirty++] = series - ingest->_series;
+    }
+
+    point = series->points + series->n++;
+    point->ts = ts;
+    point->via = *via;
+
+    ingest->n_points++;
+
+    return (++ingest->_npoints >= ingest->max_points) ?
+            suv_ingest_flush(ingest) : 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * suv_ingest.h - Stream CSV or Graphite plaintext into SiriDB inserts.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_INGEST_H_
+#define SUV_INGEST_H_
+
+#include <suv.h>
+
+/* type definitions */
+typedef struct suv_ingest_s suv_ingest_t;
+
+typedef enum
+{
+    SUV_INGEST_FMT_GRAPHITE,/* <name> <value> <timestamp> */
+    SUV_INGEST_FMT_CSV      /* <name>,<timestamp>,<value> */
+} suv_ingest_fmt_t;
+
+typedef void (*suv_ingest_cb) (suv_ingest_t * ingest, int status);
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_ingest_t * suv_ingest_create(suv_buf_t * bufs[], size_t n);
+void suv_ingest_destroy(suv_ingest_t * ingest);
+int suv_ingest_add_int64(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    int64_t val);
+int suv_ingest_add_real(
+    suv_ingest_t * ingest,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    double val);
+int suv_ingest_parse(suv_ingest_t * ingest, const char * data, size_t len);
+int suv_ingest_flush(suv_ingest_t * ingest);
+int suv_ingest_fd(
+    suv_ingest_t * ingest,
+    uv_loop_t * loop,
+    uv_file fd,
+    suv_ingest_cb cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+typedef struct suv__ingest_series_s suv__ingest_series_t;
+
+struct suv_ingest_s
+{
+    void * data;                /* public */
+    suv_ingest_fmt_t fmt;       /* public, default SUV_INGEST_FMT_GRAPHITE */
+    size_t max_points;          /* public, points per insert package */
+    size_t max_pending;         /* public, packages in flight */
+    uint64_t ts_multiplier;     /* public, for Graphite timestamps */
+    uint64_t n_lines;           /* readonly */
+    uint64_t n_invalid;         /* readonly, lines which are skipped */
+    uint64_t n_points;          /* readonly */
+    uint64_t n_packages;        /* readonly */
+    uint64_t n_failed;          /* readonly, packages with an error */
+    suv_ingest_cb _cb;
+    suv_buf_t ** _bufs;
+    size_t _nbufs;
+    size_t _next;
+    size_t _pending;
+    size_t _npoints;
+    suv__ingest_series_t * _series;
+    size_t _nseries;
+    size_t _sseries;
+    uint32_t * _table;
+    size_t _mask;
+    uint32_t * _dirty;
+    size_t _ndirty;
+    char * _carry;
+    size_t _ncarry;
+    size_t _scarry;
+    char * _rbuf[2];
+    size_t _ridx;
+    int _reading;
+    int _paused;
+    int _eof;
+    int _status;
+    uv_file _fd;
+    uv_loop_t * _loop;
+    uv_fs_t _fsreq;
+};
+
+#endif /* SUV_INGEST_H_ */
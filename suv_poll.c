@@ -0,0 +1,608 @@
+/*
+ * suv_poll.c - Incremental polling of many series.
+ *
+ *  Instead of a query per series, all series which are due are merged into
+ *  a few queries like: select * from 'a', 'b', 'c' after <ts>. Due series
+ *  are sorted by their last timestamp and a query only holds series whose
+ *  last timestamps differ at most max_spread, so a new or lagging series
+ *  does not make the others fetch their history again. The smallest
+ *  timestamp is used and points which are already seen are dropped for each
+ *  series.
+ *
+ *  SiriDB fails the whole query when one of the series does not exist. When
+ *  a merged query fails, each series is queried alone. A series whose own
+ *  query fails is marked as failed and reported; it is only polled alone,
+ *  at the maximum interval, until a query succeeds again.
+ *
+ *  The interval of a series is halved when a poll returns new points and
+ *  grows by half when a poll returns nothing, within the minimum and
+ *  maximum interval of the poll object.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_poll.h"
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+typedef struct
+{
+    suv_poll_t * poll;
+    size_t n;
+    suv_poll_series_t * series[];
+} suv__poll_batch_t;
+
+static void suv__poll_timer_cb(uv_timer_t * handle);
+static void suv__poll_query(
+    suv_poll_t * poll,
+    suv_poll_series_t ** series,
+    size_t n);
+static void suv__poll_cb(siridb_req_t * req);
+static void suv__poll_split(
+    suv_poll_t * poll,
+    suv__poll_batch_t * batch,
+    uint64_t now);
+static void suv__poll_failed(
+    suv_poll_t * poll,
+    suv_poll_series_t * series,
+    const char * msg,
+    uint64_t now);
+static void suv__poll_points(
+    suv_poll_series_t * series,
+    suv_select_series_t * points);
+static void suv__poll_done(
+    suv_poll_t * poll,
+    suv_poll_series_t * series,
+    int has_data,
+    uint64_t now);
+static void suv__poll_error(suv_poll_t * poll, const char * msg);
+static void suv__poll_close_cb(uv_handle_t * handle);
+static void suv__poll_destroy(suv_poll_t * poll);
+static int suv__poll_cmp(const void * a, const void * b);
+
+/*
+ * Create and return a poll object or NULL in case of an allocation error.
+ * All queries are sent using the given connection. Call suv_poll_start() to
+ * start polling.
+ */
+suv_poll_t * suv_poll_create(uv_loop_t * loop, suv_buf_t * buf)
+{
+    suv_poll_t * poll = (suv_poll_t *) malloc(sizeof(suv_poll_t));
+    if (poll != NULL)
+    {
+        poll->data = NULL;
+        poll->min_interval = SUV_POLL_MIN_INTERVAL;
+        poll->max_interval = SUV_POLL_MAX_INTERVAL;
+        poll->max_series = SUV_POLL_MAX_SERIES;
+        poll->max_spread = SUV_POLL_MAX_SPREAD;
+        poll->onerror = NULL;
+        poll->n_queries = 0;
+        poll->n_polls = 0;
+        poll->n_failed = 0;
+        poll->_buf = buf;
+        poll->_series = NULL;
+        poll->_n = 0;
+        poll->_size = 0;
+        poll->_due = NULL;
+        poll->_pending = 0;
+        poll->_cb = NULL;
+        poll->_closing = 0;
+
+        uv_timer_init(loop, &poll->_timer);
+        poll->_timer.data = (void *) poll;
+    }
+    return poll;
+}
+
+/*
+ * Start polling. The due series are checked every min_interval
+ * milliseconds. Returns 0 if successful or a libuv error code.
+ */
+int suv_poll_start(suv_poll_t * poll)
+{
+    return uv_timer_start(
+        &poll->_timer,
+        suv__poll_timer_cb,
+        poll->min_interval,
+        poll->min_interval);
+}
+
+/*
+ * Stop polling and destroy the poll object and all its series when the
+ * pending queries are finished. Series callbacks are not called anymore.
+ * The callback is optional.
+ */
+void suv_poll_close(suv_poll_t * poll, suv_poll_close_cb cb)
+{
+    assert (!poll->_closing);  /* close is already called */
+
+    poll->_cb = cb;
+    poll->_closing = 1;
+    uv_timer_stop(&poll->_timer);
+    uv_close((uv_handle_t *) &poll->_timer, suv__poll_close_cb);
+}
+
+/*
+ * Add a series and return the series object or NULL in case of an
+ * allocation error. Only points with a timestamp after 'after' are
+ * returned. The series is polled at the next tick.
+ */
+suv_poll_series_t * suv_poll_add(
+    suv_poll_t * poll,
+    const char * name,
+    uint64_t after,
+    suv_poll_cb cb)
+{
+    size_t len = strlen(name);
+    suv_poll_series_t * series;
+
+    if (poll->_n == poll->_size)
+    {
+        size_t sz = poll->_size ? poll->_size * 2 : 64;
+        suv_poll_series_t ** tmp = (suv_poll_series_t **) realloc(
+                poll->_series, sizeof(suv_poll_series_t *) * sz);
+        if (tmp == NULL)
+        {
+            return NULL;
+        }
+        poll->_series = tmp;
+
+        tmp = (suv_poll_series_t **) realloc(
+                poll->_due, sizeof(suv_poll_series_t *) * sz);
+        if (tmp == NULL)
+        {
+            return NULL;
+        }
+        poll->_due = tmp;
+        poll->_size = sz;
+    }
+
+    series = (suv_poll_series_t *) malloc(sizeof(suv_poll_series_t) + len + 1);
+    if (series == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(series + 1, name, len + 1);
+    series->data = NULL;
+    series->name = (const char *) (series + 1);
+    series->last_ts = after;
+    series->interval = poll->min_interval;
+    series->n_points = 0;
+    series->failed = 0;
+    series->_cb = cb;
+    series->_due = 0;
+    series->_idx = poll->_n;
+    series->_busy = 0;
+    series->_removed = 0;
+
+    poll->_series[poll->_n++] = series;
+    return series;
+}
+
+/*
+ * Remove and destroy a series. A series which is being polled is destroyed
+ * when the query is finished; its callback will not be called anymore.
+ */
+void suv_poll_remove(suv_poll_t * poll, suv_poll_series_t * series)
+{
+    assert (!series->_removed);  /* remove is already called */
+
+    suv_poll_series_t * last = poll->_series[--poll->_n];
+    last->_idx = series->_idx;
+    poll->_series[series->_idx] = last;
+
+    if (series->_busy)
+    {
+        series->_removed = 1;
+    }
+    else
+    {
+        free(series);
+    }
+}
+
+static void suv__poll_timer_cb(uv_timer_t * handle)
+{
+    suv_poll_t * poll = (suv_poll_t *) handle->data;
+    uint64_t now = uv_now(handle->loop);
+    size_t i, k, n = 0;
+
+    for (i = 0; i < poll->_n; i++)
+    {
+        suv_poll_series_t * series = poll->_series[i];
+        if (!series->_busy && series->_due <= now)
+        {
+            series->_busy = 1;
+            if (series->failed)
+            {
+                suv__poll_query(poll, &series, 1);
+            }
+            else
+            {
+                poll->_due[n++] = series;
+            }
+        }
+    }
+
+    qsort(poll->_due, n, sizeof(suv_poll_series_t *), suv__poll_cmp);
+
+    for (i = 0; i < n; i += k)
+    {
+        uint64_t first_ts = poll->_due[i]->last_ts;
+        k = 1;
+        while (i + k < n &&
+               k < poll->max_series &&
+               poll->_due[i + k]->last_ts - first_ts <= poll->max_spread)
+        {
+            k++;
+        }
+        suv__poll_query(poll, poll->_due + i, k);
+    }
+}
+
+/*
+ * Send one query for the given series. The series are marked busy.
+ */
+static void suv__poll_query(
+    suv_poll_t * poll,
+    suv_poll_series_t ** series,
+    size_t n)
+{
+    static const char select[] = "select * from ";
+    suv__poll_batch_t * batch;
+    siridb_req_t * req = NULL;
+    suv_query_t * query = NULL;
+    char * q, * pt;
+    size_t i, sz = sizeof(select) + 32;
+    int rc = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        /* quotes, escaped quotes and separator */
+        sz += strlen(series[i]->name) * 2 + 4;
+    }
+
+    q = (char *) malloc(sz);
+    batch = (suv__poll_batch_t *) malloc(
+            sizeof(suv__poll_batch_t) + sizeof(suv_poll_series_t *) * n);
+
+    if (q != NULL && batch != NULL)
+    {
+        memcpy(q, select, sizeof(select) - 1);
+        pt = q + sizeof(select) - 1;
+
+        for (i = 0; i < n; i++)
+        {
+            const char * name = series[i]->name;
+            if (i)
+            {
+                *pt++ = ',';
+                *pt++ = ' ';
+            }
+            *pt++ = '\'';
+            for (; *name; name++)
+            {
+                if (*name == '\'')
+                {
+                    *pt++ = '\'';
+                }
+                *pt++ = *name;
+            }
+            *pt++ = '\'';
+            batch->series[i] = series[i];
+        }
+
+        /* series are sorted so the first has the smallest timestamp */
+        sprintf(pt, " after %" PRIu64, series[0]->last_ts);
+
+        batch->poll = poll;
+        batch->n = n;
+
+        req = siridb_req_create(poll->_buf->siridb, suv__poll_cb, &rc);
+        query = (req == NULL) ? NULL : suv_query_create(req, q);
+    }
+
+    free(q);
+
+    if (query == NULL)
+    {
+        uint64_t now = uv_now(poll->_timer.loop);
+
+        free(batch);
+        if (req != NULL)
+        {
+            siridb_req_destroy(req);
+        }
+        for (i = 0; i < n; i++)
+        {
+            suv__poll_done(poll, series[i], 0, now);
+        }
+        suv__poll_error(poll, siridb_strerror(rc ? rc : ERR_MEM_ALLOC));
+        return;
+    }
+
+    query->data = (void *) batch;
+    req->data = (void *) query;
+
+    poll->_pending++;
+    poll->n_queries++;
+    poll->n_polls += n;
+
+    suv_query(query);
+}
+
+static void suv__poll_cb(siridb_req_t * req)
+{
+    suv_query_t * query = (suv_query_t *) req->data;
+    suv__poll_batch_t * batch = (suv__poll_batch_t *) query->data;
+    suv_poll_t * poll = batch->poll;
+    suv_select_t * select = NULL;
+    const char * msg = NULL;
+    uint64_t now = uv_now(poll->_timer.loop);
+    size_t i, j;
+    int rc;
+
+    if (req->status)
+    {
+        msg = suv_strerror(req->status);
+    }
+    else if (req->pkg->tp == CprotoErrQuery && !poll->_closing)
+    {
+        /* for example when a series does not exist */
+        siridb_resp_t * resp = siridb_resp_create(req->pkg, &rc);
+        poll->n_failed++;
+
+        if (batch->n > 1)
+        {
+            suv__poll_split(poll, batch, now);
+        }
+        else
+        {
+            suv__poll_failed(
+                poll,
+                batch->series[0],
+                (resp != NULL && resp->tp == SIRIDB_RESP_TP_ERROR_MSG) ?
+                        resp->via.error_msg : "poll query failed",
+                now);
+        }
+
+        if (resp != NULL)
+        {
+            siridb_resp_destroy(resp);
+        }
+        batch->n = 0;
+    }
+    else if (req->pkg->tp != CprotoResQuery)
+    {
+        msg = "poll query failed";
+    }
+    else if ((select = suv_select_create(req->pkg, &rc)) == NULL)
+    {
+        msg = siridb_strerror(rc);
+    }
+
+    for (i = 0; select != NULL && i < select->n; i++)
+    {
+        suv_select_series_t * points = select->series + i;
+
+        for (j = 0; j < batch->n; j++)
+        {
+            suv_poll_series_t * series = batch->series[j];
+            if (series != NULL && strcmp(series->name, points->name) == 0)
+            {
+                batch->series[j] = NULL;
+                if (!poll->_closing)
+                {
+                    suv__poll_points(series, points);
+                }
+                series->failed = 0;
+                suv__poll_done(poll, series, points->n > 0, now);
+                break;
+            }
+        }
+    }
+
+    /* series without points in the response */
+    for (j = 0; j < batch->n; j++)
+    {
+        if (batch->series[j] != NULL)
+        {
+            if (msg == NULL)
+            {
+                batch->series[j]->failed = 0;
+            }
+            suv__poll_done(poll, batch->series[j], 0, now);
+        }
+    }
+
+    if (msg != NULL)
+    {
+        poll->n_failed++;
+        suv__poll_error(poll, msg);
+    }
+
+    if (select != NULL)
+    {
+        suv_select_destroy(select);
+    }
+    free(batch);
+    suv_query_destroy(query);
+    siridb_req_destroy(req);
+
+    /* the timer data is cleared when the timer is closed */
+    if (--poll->_pending == 0 && poll->_timer.data == NULL)
+    {
+        suv__poll_destroy(poll);
+    }
+}
+
+/*
+ * Query each series of a failed merged query alone, so a series which does
+ * not exist cannot stop the others from being polled.
+ */
+static void suv__poll_split(
+    suv_poll_t * poll,
+    suv__poll_batch_t * batch,
+    uint64_t now)
+{
+    for (size_t i = 0; i < batch->n; i++)
+    {
+        suv_poll_series_t * series = batch->series[i];
+        if (series->_removed)
+        {
+            suv__poll_done(poll, series, 0, now);
+        }
+        else
+        {
+            /* the series stays busy */
+            suv__poll_query(poll, &series, 1);
+        }
+    }
+}
+
+/*
+ * Mark a series as failed and report the error. The series is polled alone
+ * at the maximum interval until a query succeeds.
+ */
+static void suv__poll_failed(
+    suv_poll_t * poll,
+    suv_poll_series_t * series,
+    const char * msg,
+    uint64_t now)
+{
+    char buf[512];
+
+    if (!series->_removed)
+    {
+        snprintf(buf, sizeof(buf), "poll of '%s' failed: %s", series->name, msg);
+        series->failed = 1;
+        series->interval = poll->max_interval;
+        suv__poll_error(poll, buf);
+    }
+    suv__poll_done(poll, series, 0, now);
+}
+
+/*
+ * Call the series callback with the points after the last timestamp. The
+ * points are ordered by timestamp. The points argument is changed.
+ */
+static void suv__poll_points(
+    suv_poll_series_t * series,
+    suv_select_series_t * points)
+{
+    size_t k = 0;
+
+    while (k < points->n && points->ts[k] <= series->last_ts)
+    {
+        k++;
+    }
+
+    points->n -= k;
+    if (points->n == 0 || series->_removed)
+    {
+        points->n = 0;
+        return;
+    }
+
+    points->ts += k;
+    switch (points->tp)
+    {
+    case SIRIDB_SERIES_TP_INT64:
+        points->via.int64 += k;
+        break;
+    case SIRIDB_SERIES_TP_REAL:
+        points->via.real += k;
+        break;
+    case SIRIDB_SERIES_TP_STR:
+        points->via.str += k;
+        break;
+    }
+
+    series->last_ts = points->ts[points->n - 1];
+    series->n_points += points->n;
+    series->_cb(series, points);
+}
+
+/*
+ * Schedule the next poll of a series, or destroy the series when it is
+ * removed while it was polled.
+ */
+static void suv__poll_done(
+    suv_poll_t * poll,
+    suv_poll_series_t * series,
+    int has_data,
+    uint64_t now)
+{
+    if (series->_removed)
+    {
+        free(series);
+        return;
+    }
+
+    if (has_data)
+    {
+        series->interval /= 2;
+    }
+    else
+    {
+        series->interval += series->interval / 2 + 1;
+    }
+
+    if (series->interval < poll->min_interval)
+    {
+        series->interval = poll->min_interval;
+    }
+    else if (series->interval > poll->max_interval)
+    {
+        series->interval = poll->max_interval;
+    }
+
+    series->_busy = 0;
+    series->_due = now + series->interval;
+}
+
+static void suv__poll_error(suv_poll_t * poll, const char * msg)
+{
+    if (poll->onerror != NULL)
+    {
+        poll->onerror(poll, msg);
+    }
+}
+
+static void suv__poll_close_cb(uv_handle_t * handle)
+{
+    suv_poll_t * poll = (suv_poll_t *) handle->data;
+
+    /* marks the timer as closed */
+    handle->data = NULL;
+
+    if (poll->_pending == 0)
+    {
+        suv__poll_destroy(poll);
+    }
+}
+
+static void suv__poll_destroy(suv_poll_t * poll)
+{
+    for (size_t i = 0; i < poll->_n; i++)
+    {
+        free(poll->_series[i]);
+    }
+    free(poll->_series);
+    free(poll->_due);
+
+    if (poll->_cb != NULL)
+    {
+        poll->_cb(poll);
+    }
+    free(poll);
+}
+
+static int suv__poll_cmp(const void * a, const void * b)
+{
+    uint64_t x = (*(suv_poll_series_t * const *) a)->last_ts;
+    uint64_t y = (*(suv_poll_series_t * const *) b)->last_ts;
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,85 @@
+/*
+ * suv_poll.h - Incremental polling of many series.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_POLL_H_
+#define SUV_POLL_H_
+
+#include <suv.h>
+#include <suv_select.h>
+
+#define SUV_POLL_MIN_INTERVAL 1000      /* milliseconds */
+#define SUV_POLL_MAX_INTERVAL 60000     /* milliseconds */
+#define SUV_POLL_MAX_SERIES 100
+#define SUV_POLL_MAX_SPREAD 3600        /* database time precision */
+
+/* type definitions */
+typedef struct suv_poll_s suv_poll_t;
+typedef struct suv_poll_series_s suv_poll_series_t;
+
+typedef void (*suv_poll_cb) (
+    suv_poll_series_t * series,
+    suv_select_series_t * points);
+typedef void (*suv_poll_err_cb) (suv_poll_t * poll, const char * msg);
+typedef void (*suv_poll_close_cb) (suv_poll_t * poll);
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_poll_t * suv_poll_create(uv_loop_t * loop, suv_buf_t * buf);
+int suv_poll_start(suv_poll_t * poll);
+void suv_poll_close(suv_poll_t * poll, suv_poll_close_cb cb);
+suv_poll_series_t * suv_poll_add(
+    suv_poll_t * poll,
+    const char * name,
+    uint64_t after,
+    suv_poll_cb cb);
+void suv_poll_remove(suv_poll_t * poll, suv_poll_series_t * series);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_poll_series_s
+{
+    void * data;                /* public */
+    const char * name;          /* readonly */
+    uint64_t last_ts;           /* readonly, last received timestamp */
+    uint64_t interval;          /* readonly, poll interval in milliseconds */
+    uint64_t n_points;          /* readonly */
+    int failed;                 /* readonly, last query failed */
+    suv_poll_cb _cb;
+    uint64_t _due;
+    size_t _idx;
+    int _busy;
+    int _removed;
+};
+
+struct suv_poll_s
+{
+    void * data;                /* public */
+    uint64_t min_interval;      /* public, milliseconds */
+    uint64_t max_interval;      /* public, milliseconds */
+    size_t max_series;          /* public, series per query */
+    uint64_t max_spread;        /* public, last_ts difference per query */
+    suv_poll_err_cb onerror;    /* public */
+    uint64_t n_queries;         /* readonly */
+    uint64_t n_polls;           /* readonly, number of series polled */
+    uint64_t n_failed;          /* readonly, queries with an error */
+    suv_buf_t * _buf;
+    uv_timer_t _timer;
+    suv_poll_series_t ** _series;
+    size_t _n;
+    size_t _size;
+    suv_poll_series_t ** _due;
+    size_t _pending;
+    suv_poll_close_cb _cb;
+    int _closing;
+};
+
+#endif /* SUV_POLL_H_ */
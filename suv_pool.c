@@ -0,0 +1,109 @@
+/*
+ * suv_pool.c - Shared read buffer pool.
+ *
+ *  With the default read buffers each connection keeps a buffer of the
+ *  size suggested by libuv, and after a large response a buffer of the
+ *  response size. A pool is shared by all connections on a loop: reads use
+ *  a block from the pool which is returned when the read is handled, so an
+ *  idle connection only keeps the bytes of an incomplete package. A pool is
+ *  not thread safe so use one pool per loop.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_pool.h"
+#include <string.h>
+
+extern const long int MAX_PKG_SIZE;
+
+/*
+ * Create and return a pool object or NULL in case of an allocation error.
+ * Use 0 for the default block size. Set suv_buf_t.pool before calling
+ * suv_connect() to use the pool for a connection.
+ */
+suv_pool_t * suv_pool_create(size_t block_size)
+{
+    suv_pool_t * pool = (suv_pool_t *) malloc(sizeof(suv_pool_t));
+    if (pool != NULL)
+    {
+        pool->data = NULL;
+        pool->max_free = SUV_POOL_MAX_FREE;
+        pool->max_idle = SUV_POOL_MAX_IDLE;
+        pool->max_conn = (size_t) MAX_PKG_SIZE + sizeof(siridb_pkg_t);
+        pool->max_total = 0;
+        pool->block_size = (block_size < sizeof(char *)) ?
+                SUV_POOL_BLOCK_SIZE : block_size;
+        pool->total = 0;
+        pool->_nfree = 0;
+        pool->_free = NULL;
+    }
+    return pool;
+}
+
+/*
+ * Destroy a pool object. Make sure all connections using the pool are
+ * destroyed first.
+ */
+void suv_pool_destroy(suv_pool_t * pool)
+{
+    while (pool->_free != NULL)
+    {
+        char * block = pool->_free;
+        memcpy(&pool->_free, block, sizeof(char *));
+        free(block);
+    }
+    free(pool);
+}
+
+/*
+ * Return a block of pool->block_size bytes or NULL when the pool limit is
+ * reached or in case of an allocation error.
+ */
+char * suv_pool_get(suv_pool_t * pool)
+{
+    char * block;
+
+    if (suv_pool_reserve(pool, pool->block_size))
+    {
+        return NULL;
+    }
+
+    if (pool->_free != NULL)
+    {
+        block = pool->_free;
+        memcpy(&pool->_free, block, sizeof(char *));
+        pool->_nfree--;
+        return block;
+    }
+
+    block = (char *) malloc(pool->block_size);
+    if (block == NULL)
+    {
+        suv_pool_release(pool, pool->block_size);
+    }
+    return block;
+}
+
+/*
+ * Return a block to the pool. The block may be NULL.
+ */
+void suv_pool_put(suv_pool_t * pool, char * block)
+{
+    if (block == NULL)
+    {
+        return;
+    }
+
+    suv_pool_release(pool, pool->block_size);
+
+    if (pool->_nfree < pool->max_free)
+    {
+        memcpy(block, &pool->_free, sizeof(char *));
+        pool->_free = block;
+        pool->_nfree++;
+    }
+    else
+    {
+        free(block);
+    }
+}
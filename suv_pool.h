@@ -0,0 +1,66 @@
+/*
+ * suv_pool.h - Shared read buffer pool.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_POOL_H_
+#define SUV_POOL_H_
+
+#include <suv.h>
+
+#define SUV_POOL_BLOCK_SIZE 65536
+#define SUV_POOL_MAX_FREE 16
+#define SUV_POOL_MAX_IDLE 4096
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_pool_t * suv_pool_create(size_t block_size);
+void suv_pool_destroy(suv_pool_t * pool);
+char * suv_pool_get(suv_pool_t * pool);
+void suv_pool_put(suv_pool_t * pool, char * block);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_pool_s
+{
+    void * data;            /* public */
+    size_t max_free;        /* public, number of free blocks to keep */
+    size_t max_idle;        /* public, per connection storage to keep */
+    size_t max_conn;        /* public, per connection limit */
+    size_t max_total;       /* public, pool limit or 0 for no limit */
+    size_t block_size;      /* readonly */
+    size_t total;           /* readonly, number of bytes in use */
+    size_t _nfree;
+    char * _free;           /* free blocks, linked by their first bytes */
+};
+
+/*
+ * Reserve memory for per connection storage. Returns 0 if successful or -1
+ * when the pool limit is reached.
+ */
+static inline int suv_pool_reserve(suv_pool_t * pool, size_t n)
+{
+    if (pool->max_total && pool->total + n > pool->max_total)
+    {
+        return -1;
+    }
+    pool->total += n;
+    return 0;
+}
+
+/*
+ * Release memory reserved with suv_pool_reserve().
+ */
+static inline void suv_pool_release(suv_pool_t * pool, size_t n)
+{
+    pool->total -= n;
+}
+
+#endif /* SUV_POOL_H_ */
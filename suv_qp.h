@@ -0,0 +1,248 @@
+/*
+ * suv_qp.h - Private qpack helpers used by libsuv.
+ *
+ *  libsiridb packs data using libqpack which requires a packer object and a
+ *  function call for each value. The functions below write the qpack format
+ *  directly into a growing buffer so hot paths can pack a package without
+ *  building intermediate objects.
+ *
+ *  This header is not installed.
+ */
+
+#ifndef SUV_QP_H_
+#define SUV_QP_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libsiridb/siridb.h>
+
+/* qpack type bytes */
+#define SUV__QP_INT_NEG_1   64      /* -1 .. -60 are 64 .. 123 */
+#define SUV__QP_DOUBLE_N1   125
+#define SUV__QP_DOUBLE_0    126
+#define SUV__QP_DOUBLE_1    127
+#define SUV__QP_RAW0        128     /* raw with length 0 .. 99 */
+#define SUV__QP_RAW8        228
+#define SUV__QP_RAW16       229
+#define SUV__QP_RAW32       230
+#define SUV__QP_RAW64       231
+#define SUV__QP_INT8        232
+#define SUV__QP_INT16       233
+#define SUV__QP_INT32       234
+#define SUV__QP_INT64       235
+#define SUV__QP_DOUBLE      236
+#define SUV__QP_ARRAY0      237     /* array with 0 .. 5 items */
+#define SUV__QP_MAP0        243     /* map with 0 .. 5 items */
+#define SUV__QP_TRUE        249
+#define SUV__QP_FALSE       250
+#define SUV__QP_NULL        251
+#define SUV__QP_ARRAY_OPEN  252
+#define SUV__QP_MAP_OPEN    253
+#define SUV__QP_ARRAY_CLOSE 254
+#define SUV__QP_MAP_CLOSE   255
+
+typedef struct suv__qp_s
+{
+    unsigned char * data;
+    size_t len;
+    size_t size;
+} suv__qp_t;
+
+/*
+ * Make sure at least n bytes are available. Returns 0 if successful or -1
+ * in case of an allocation error.
+ */
+static inline int suv__qp_reserve(suv__qp_t * qp, size_t n)
+{
+    if (qp->len + n > qp->size)
+    {
+        size_t sz = qp->size ? qp->size : 1024;
+        while (sz < qp->len + n)
+        {
+            sz <<= 1;
+        }
+        unsigned char * tmp = (unsigned char *) realloc(qp->data, sz);
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        qp->data = tmp;
+        qp->size = sz;
+    }
+    return 0;
+}
+
+/*
+ * The suv__qp_add_*() functions below expect enough space to be reserved.
+ * Nine bytes is enough for any single number or container type.
+ */
+static inline void suv__qp_add_type(suv__qp_t * qp, uint8_t tp)
+{
+    qp->data[qp->len++] = tp;
+}
+
+static inline void suv__qp_add_int64(suv__qp_t * qp, int64_t i)
+{
+    unsigned char * pt = qp->data + qp->len;
+    if (i >= 0 && i < 64)
+    {
+        *pt = (uint8_t) i;
+        qp->len += 1;
+    }
+    else if (i < 0 && i >= -60)
+    {
+        *pt = (uint8_t) (63 - i);
+        qp->len += 1;
+    }
+    else if (i == (int8_t) i)
+    {
+        int8_t v = (int8_t) i;
+        *pt = SUV__QP_INT8;
+        memcpy(pt + 1, &v, sizeof(int8_t));
+        qp->len += 1 + sizeof(int8_t);
+    }
+    else if (i == (int16_t) i)
+    {
+        int16_t v = (int16_t) i;
+        *pt = SUV__QP_INT16;
+        memcpy(pt + 1, &v, sizeof(int16_t));
+        qp->len += 1 + sizeof(int16_t);
+    }
+    else if (i == (int32_t) i)
+    {
+        int32_t v = (int32_t) i;
+        *pt = SUV__QP_INT32;
+        memcpy(pt + 1, &v, sizeof(int32_t));
+        qp->len += 1 + sizeof(int32_t);
+    }
+    else
+    {
+        *pt = SUV__QP_INT64;
+        memcpy(pt + 1, &i, sizeof(int64_t));
+        qp->len += 1 + sizeof(int64_t);
+    }
+}
+
+static inline void suv__qp_add_double(suv__qp_t * qp, double d)
+{
+    unsigned char * pt = qp->data + qp->len;
+    if (d == 0.0)
+    {
+        *pt = SUV__QP_DOUBLE_0;
+        qp->len += 1;
+    }
+    else if (d == 1.0)
+    {
+        *pt = SUV__QP_DOUBLE_1;
+        qp->len += 1;
+    }
+    else if (d == -1.0)
+    {
+        *pt = SUV__QP_DOUBLE_N1;
+        qp->len += 1;
+    }
+    else
+    {
+        *pt = SUV__QP_DOUBLE;
+        memcpy(pt + 1, &d, sizeof(double));
+        qp->len += 1 + sizeof(double);
+    }
+}
+
+/*
+ * Add a raw string. Reserves the required space itself and returns 0 if
+ * successful or -1 in case of an allocation error.
+ */
+static inline int suv__qp_add_raw(suv__qp_t * qp, const char * raw, size_t n)
+{
+    if (suv__qp_reserve(qp, n + 9))
+    {
+        return -1;
+    }
+    unsigned char * pt = qp->data + qp->len;
+    if (n < 100)
+    {
+        *pt++ = (uint8_t) (SUV__QP_RAW0 + n);
+    }
+    else if (n <= UINT8_MAX)
+    {
+        uint8_t sz = (uint8_t) n;
+        *pt++ = SUV__QP_RAW8;
+        memcpy(pt, &sz, sizeof(uint8_t));
+        pt += sizeof(uint8_t);
+    }
+    else if (n <= UINT16_MAX)
+    {
+        uint16_t sz = (uint16_t) n;
+        *pt++ = SUV__QP_RAW16;
+        memcpy(pt, &sz, sizeof(uint16_t));
+        pt += sizeof(uint16_t);
+    }
+    else
+    {
+        uint32_t sz = (uint32_t) n;
+        *pt++ = SUV__QP_RAW32;
+        memcpy(pt, &sz, sizeof(uint32_t));
+        pt += sizeof(uint32_t);
+    }
+    memcpy(pt, raw, n);
+    qp->len = (pt - qp->data) + n;
+    return 0;
+}
+
+/*
+ * Add an array or map header for n items. Returns 1 when a close type must
+ * be added after the items and 0 otherwise.
+ */
+static inline int suv__qp_add_array(suv__qp_t * qp, size_t n)
+{
+    if (n <= 5)
+    {
+        suv__qp_add_type(qp, (uint8_t) (SUV__QP_ARRAY0 + n));
+        return 0;
+    }
+    suv__qp_add_type(qp, SUV__QP_ARRAY_OPEN);
+    return 1;
+}
+
+static inline int suv__qp_add_map(suv__qp_t * qp, size_t n)
+{
+    if (n <= 5)
+    {
+        suv__qp_add_type(qp, (uint8_t) (SUV__QP_MAP0 + n));
+        return 0;
+    }
+    suv__qp_add_type(qp, SUV__QP_MAP_OPEN);
+    return 1;
+}
+
+/*
+ * Reserve room for a siridb_pkg_t header at the start of the buffer.
+ */
+static inline int suv__qp_init_pkg(suv__qp_t * qp)
+{
+    qp->len = 0;
+    if (suv__qp_reserve(qp, sizeof(siridb_pkg_t)))
+    {
+        return -1;
+    }
+    qp->len = sizeof(siridb_pkg_t);
+    return 0;
+}
+
+/*
+ * Fill the package header and return the buffer as package. The pid will be
+ * set once the package is bound to a request.
+ */
+static inline siridb_pkg_t * suv__qp_to_pkg(suv__qp_t * qp, uint8_t tp)
+{
+    siridb_pkg_t * pkg = (siridb_pkg_t *) qp->data;
+    pkg->len = (uint32_t) (qp->len - sizeof(siridb_pkg_t));
+    pkg->pid = 0;
+    pkg->tp = tp;
+    pkg->checkbit = (uint8_t) ~tp;
+    return pkg;
+}
+
+#endif /* SUV_QP_H_ */
@@ -0,0 +1,676 @@
+/*
+ * suv_select.c - Decode select results into columnar arrays.
+ *
+ *  A select result is a map with for each series an array of [ts, value]
+ *  points. Instead of a struct per point, the result is decoded into an
+ *  array of timestamps and an array of values per series. The package is
+ *  read twice: once to count the series, points and bytes, and once to
+ *  decode into a single allocation which holds everything.
+ *
+ *  Runs of points which share the same layout, for example an int64
+ *  timestamp with a double value, are decoded by a fixed stride loop
+ *  without type dispatch per value.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_select.h"
+#include "suv_qp.h"
+
+#define SUV__SELECT_ALIGN(sz__) (((sz__) + 7) & ~((size_t) 7))
+#define SUV__SELECT_OPEN SIZE_MAX   /* number of items in an open container */
+
+typedef struct
+{
+    size_t nseries;
+    size_t npoints;
+    size_t nbytes;              /* names and strings */
+} suv__select_size_t;
+
+static int suv__select_read(
+    const unsigned char * pt,
+    const unsigned char * end,
+    suv__select_size_t * size,
+    suv_select_t * select,
+    char * bytes);
+static int suv__select_series(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    suv__select_size_t * size,
+    suv_select_series_t * series,
+    unsigned char * vals,
+    char ** bytes);
+static size_t suv__select_run(
+    const unsigned char * pt,
+    const unsigned char * end,
+    size_t n,
+    size_t ts_sz,
+    uint8_t val_tp,
+    uint64_t * ts,
+    unsigned char * vals);
+static int suv__select_container(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    uint8_t tp0,
+    uint8_t open,
+    size_t * n);
+static int suv__select_next(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    size_t * n,
+    uint8_t close);
+static int suv__select_value(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    int64_t * i,
+    double * d,
+    const char ** s,
+    size_t * len);
+static int suv__select_skip(
+    const unsigned char ** pt,
+    const unsigned char * end);
+
+/*
+ * Create and return a select object from a select response package, or
+ * NULL in case of an error in which case rc is set to ERR_INVALID_RESP or
+ * ERR_MEM_ALLOC. The select object does not depend on the package which can
+ * be destroyed.
+ */
+suv_select_t * suv_select_create(siridb_pkg_t * pkg, int * rc)
+{
+    const unsigned char * end = pkg->data + pkg->len;
+    suv__select_size_t size = {0, 0, 0};
+    suv_select_t * select;
+    size_t sz, offset;
+
+    if (pkg->tp != CprotoResQuery ||
+        suv__select_read(pkg->data, end, &size, NULL, NULL))
+    {
+        *rc = ERR_INVALID_RESP;
+        return NULL;
+    }
+
+    offset = SUV__SELECT_ALIGN(sizeof(suv_select_t));
+    sz = offset +
+        SUV__SELECT_ALIGN(sizeof(suv_select_series_t) * size.nseries) +
+        sizeof(uint64_t) * size.npoints * 2 +
+        size.nbytes;
+
+    select = (suv_select_t *) malloc(sz);
+    if (select == NULL)
+    {
+        *rc = ERR_MEM_ALLOC;
+        return NULL;
+    }
+
+    select->data = NULL;
+    select->n = 0;
+    select->series = (suv_select_series_t *) ((char *) select + offset);
+
+    /* the package is valid so reading it again cannot fail */
+    (void) suv__select_read(
+        pkg->data,
+        end,
+        &size,
+        select,
+        (char *) select + sz - size.nbytes);
+
+    *rc = 0;
+    return select;
+}
+
+/*
+ * Destroy a select object.
+ */
+void suv_select_destroy(suv_select_t * select)
+{
+    free(select);
+}
+
+/*
+ * Read the select result. Only counts the size when select is NULL.
+ * Returns 0 if successful or -1 if the result is invalid.
+ */
+static int suv__select_read(
+    const unsigned char * pt,
+    const unsigned char * end,
+    suv__select_size_t * size,
+    suv_select_t * select,
+    char * bytes)
+{
+    uint64_t * ts = NULL;
+    unsigned char * vals = NULL;
+    const char * name;
+    size_t n, len;
+
+    if (select != NULL)
+    {
+        ts = (uint64_t *) ((char *) select->series + SUV__SELECT_ALIGN(
+                sizeof(suv_select_series_t) * size->nseries));
+        vals = (unsigned char *) (ts + size->npoints);
+    }
+    else
+    {
+        size->nseries = 0;
+        size->npoints = 0;
+        size->nbytes = 0;
+    }
+
+    if (suv__select_container(
+            &pt, end, SUV__QP_MAP0, SUV__QP_MAP_OPEN, &n))
+    {
+        return -1;
+    }
+
+    while (suv__select_next(&pt, end, &n, SUV__QP_MAP_CLOSE))
+    {
+        if (suv__select_value(&pt, end, NULL, NULL, &name, &len) !=
+                SIRIDB_SERIES_TP_STR)
+        {
+            return -1;
+        }
+
+        if (len == 10 && memcmp(name, "__timeit__", 10) == 0)
+        {
+            if (suv__select_skip(&pt, end))
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        if (select == NULL)
+        {
+            size->nseries++;
+            size->nbytes += len + 1;
+            if (suv__select_series(&pt, end, size, NULL, NULL, NULL))
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        suv_select_series_t * series = select->series + select->n++;
+
+        memcpy(bytes, name, len);
+        bytes[len] = '\0';
+        series->name = bytes;
+        bytes += len + 1;
+
+        series->ts = ts;
+        if (suv__select_series(&pt, end, size, series, vals, &bytes))
+        {
+            return -1;
+        }
+        ts += series->n;
+        vals += series->n * sizeof(uint64_t);
+    }
+
+    return (pt == end) ? 0 : -1;
+}
+
+/*
+ * Read the points of one series. Only counts the size when series is NULL.
+ * Returns 0 if successful or -1 if the points are invalid.
+ */
+static int suv__select_series(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    suv__select_size_t * size,
+    suv_select_series_t * series,
+    unsigned char * vals,
+    char ** bytes)
+{
+    siridb_series_tp tp = SIRIDB_SERIES_TP_INT64;
+    size_t i = 0, n, len;
+    const char * s;
+    int64_t ts, iv;
+    double dv;
+    int rc;
+
+    if (suv__select_container(
+            pt, end, SUV__QP_ARRAY0, SUV__QP_ARRAY_OPEN, &n))
+    {
+        return -1;
+    }
+
+    while (1)
+    {
+        if (i && tp != SIRIDB_SERIES_TP_STR)
+        {
+            /* decode a run of points with the same layout */
+            uint8_t val_tp = (tp == SIRIDB_SERIES_TP_REAL) ?
+                    SUV__QP_DOUBLE : SUV__QP_INT64;
+            for (size_t ts_sz = 8; ts_sz >= 4; ts_sz -= 4)
+            {
+                size_t k = suv__select_run(
+                        *pt,
+                        end,
+                        n,
+                        ts_sz,
+                        val_tp,
+                        (series == NULL) ? NULL : series->ts + i,
+                        (series == NULL) ? NULL : vals + i * sizeof(uint64_t));
+                if (k)
+                {
+                    *pt += k * (3 + ts_sz + sizeof(uint64_t));
+                    i += k;
+                    if (n != SUV__SELECT_OPEN)
+                    {
+                        n -= k;
+                    }
+                    if (series == NULL)
+                    {
+                        size->npoints += k;
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (!suv__select_next(pt, end, &n, SUV__QP_ARRAY_CLOSE))
+        {
+            break;
+        }
+
+        if (*pt == end || **pt != SUV__QP_ARRAY0 + 2)
+        {
+            return -1;
+        }
+        (*pt)++;
+
+        if (suv__select_value(pt, end, &ts, NULL, NULL, NULL) !=
+                SIRIDB_SERIES_TP_INT64)
+        {
+            return -1;
+        }
+
+        rc = suv__select_value(pt, end, &iv, &dv, &s, &len);
+        if (rc < 0 ||
+            (i && (rc == SIRIDB_SERIES_TP_STR) != (tp == SIRIDB_SERIES_TP_STR)))
+        {
+            return -1;
+        }
+
+        if (!i)
+        {
+            tp = (siridb_series_tp) rc;
+        }
+
+        if (series == NULL)
+        {
+            size->npoints++;
+            if (rc == SIRIDB_SERIES_TP_STR)
+            {
+                size->nbytes += len + 1;
+            }
+            i++;
+            continue;
+        }
+
+        series->ts[i] = (uint64_t) ts;
+
+        if (rc == SIRIDB_SERIES_TP_STR)
+        {
+            char * str = *bytes;
+            memcpy(str, s, len);
+            str[len] = '\0';
+            /* exposed as char ** so use the pointer size as stride, each
+             * value still has eight bytes of room */
+            memcpy(vals + i * sizeof(char *), &str, sizeof(char *));
+            *bytes += len + 1;
+        }
+        else if (tp == SIRIDB_SERIES_TP_INT64 && rc == SIRIDB_SERIES_TP_REAL)
+        {
+            /* a double in an integer series, convert the series to real */
+            for (size_t j = 0; j < i; j++)
+            {
+                int64_t v;
+                double d;
+                memcpy(&v, vals + j * sizeof(uint64_t), sizeof(int64_t));
+                d = (double) v;
+                memcpy(vals + j * sizeof(uint64_t), &d, sizeof(double));
+            }
+            tp = SIRIDB_SERIES_TP_REAL;
+            memcpy(vals + i * sizeof(uint64_t), &dv, sizeof(double));
+        }
+        else if (tp == SIRIDB_SERIES_TP_REAL)
+        {
+            if (rc == SIRIDB_SERIES_TP_INT64)
+            {
+                dv = (double) iv;
+            }
+            memcpy(vals + i * sizeof(uint64_t), &dv, sizeof(double));
+        }
+        else
+        {
+            memcpy(vals + i * sizeof(uint64_t), &iv, sizeof(int64_t));
+        }
+        i++;
+    }
+
+    if (series != NULL)
+    {
+        series->tp = tp;
+        series->n = i;
+        series->via.int64 = (int64_t *) vals;
+    }
+    return 0;
+}
+
+/*
+ * Decode points with an int64 (ts_sz 8) or int32 (ts_sz 4) timestamp and
+ * an eight byte value of type val_tp, until a point with another layout is
+ * found. Only checks the layout when ts is NULL. Returns the number of
+ * points in the run, at most n.
+ */
+static inline size_t suv__select_run(
+    const unsigned char * pt,
+    const unsigned char * end,
+    size_t n,
+    size_t ts_sz,
+    uint8_t val_tp,
+    uint64_t * ts,
+    unsigned char * vals)
+{
+    const size_t stride = 3 + ts_sz + sizeof(uint64_t);
+    const uint8_t ts_tp = (ts_sz == 8) ? SUV__QP_INT64 : SUV__QP_INT32;
+    size_t avail = (size_t) (end - pt) / stride;
+    size_t i;
+
+    n = (n < avail) ? n : avail;
+
+    for (i = 0; i < n; i++, pt += stride)
+    {
+        if (pt[0] != SUV__QP_ARRAY0 + 2 ||
+            pt[1] != ts_tp ||
+            pt[2 + ts_sz] != val_tp)
+        {
+            break;
+        }
+
+        if (ts == NULL)
+        {
+            continue;
+        }
+
+        if (ts_sz == 8)
+        {
+            memcpy(ts + i, pt + 2, sizeof(uint64_t));
+        }
+        else
+        {
+            int32_t t;
+            memcpy(&t, pt + 2, sizeof(int32_t));
+            ts[i] = (uint64_t) (int64_t) t;
+        }
+        memcpy(vals + i * sizeof(uint64_t), pt + 3 + ts_sz, sizeof(uint64_t));
+    }
+    return i;
+}
+
+/*
+ * Read a container header. Sets n to the number of items or to
+ * SUV__SELECT_OPEN for an open container. Returns 0 if successful or -1
+ * if the type is not the expected container.
+ */
+static int suv__select_container(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    uint8_t tp0,
+    uint8_t open,
+    size_t * n)
+{
+    if (*pt == end)
+    {
+        return -1;
+    }
+    if (**pt == open)
+    {
+        *n = SUV__SELECT_OPEN;
+    }
+    else if (**pt >= tp0 && **pt <= tp0 + 5)
+    {
+        *n = **pt - tp0;
+    }
+    else
+    {
+        return -1;
+    }
+    (*pt)++;
+    return 0;
+}
+
+/*
+ * Returns 1 when the container has a next item and 0 otherwise. An open
+ * container ends with the close type or at the end of the data.
+ */
+static int suv__select_next(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    size_t * n,
+    uint8_t close)
+{
+    if (*n != SUV__SELECT_OPEN)
+    {
+        return (*n)-- > 0;
+    }
+    if (*pt == end)
+    {
+        return 0;
+    }
+    if (**pt == close)
+    {
+        (*pt)++;
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Read a number or raw value. Returns SIRIDB_SERIES_TP_INT64 and sets i,
+ * SIRIDB_SERIES_TP_REAL and sets d or SIRIDB_SERIES_TP_STR and sets s and
+ * len. Returns -1 for other types or when the data is too short. Any of the
+ * output arguments may be NULL when the type is not expected.
+ */
+static int suv__select_value(
+    const unsigned char ** pt,
+    const unsigned char * end,
+    int64_t * i,
+    double * d,
+    const char ** s,
+    size_t * len)
+{
+    size_t left, sz, n;
+    uint8_t tp;
+
+    if (*pt == end)
+    {
+        return -1;
+    }
+
+    tp = *(*pt)++;
+    left = (size_t) (end - *pt);
+
+    if (tp < SUV__QP_INT_NEG_1 + 60)
+    {
+        if (i != NULL)
+        {
+            *i = (tp < SUV__QP_INT_NEG_1) ? tp : 63 - (int64_t) tp;
+        }
+        return (i != NULL) ? SIRIDB_SERIES_TP_INT64 : -1;
+    }
+
+    if (tp >= SUV__QP_DOUBLE_N1 && tp <= SUV__QP_DOUBLE_1)
+    {
+        if (d != NULL)
+        {
+            *d = (double) ((int) tp - SUV__QP_DOUBLE_0);
+        }
+        return (d != NULL) ? SIRIDB_SERIES_TP_REAL : -1;
+    }
+
+    if (tp >= SUV__QP_INT8 && tp <= SUV__QP_INT64)
+    {
+        sz = (size_t) 1 << (tp - SUV__QP_INT8);
+        if (left < sz || i == NULL)
+        {
+            return -1;
+        }
+        switch (tp)
+        {
+        case SUV__QP_INT8:
+            *i = (int8_t) **pt;
+            break;
+        case SUV__QP_INT16:
+            {
+                int16_t v;
+                memcpy(&v, *pt, sizeof(int16_t));
+                *i = v;
+            }
+            break;
+        case SUV__QP_INT32:
+            {
+                int32_t v;
+                memcpy(&v, *pt, sizeof(int32_t));
+                *i = v;
+            }
+            break;
+        default:
+            memcpy(i, *pt, sizeof(int64_t));
+        }
+        *pt += sz;
+        return SIRIDB_SERIES_TP_INT64;
+    }
+
+    if (tp == SUV__QP_DOUBLE)
+    {
+        if (left < sizeof(double) || d == NULL)
+        {
+            return -1;
+        }
+        memcpy(d, *pt, sizeof(double));
+        *pt += sizeof(double);
+        return SIRIDB_SERIES_TP_REAL;
+    }
+
+    if (tp >= SUV__QP_RAW0 && tp <= SUV__QP_RAW64)
+    {
+        if (tp < SUV__QP_RAW8)
+        {
+            n = tp - SUV__QP_RAW0;
+        }
+        else
+        {
+            sz = (size_t) 1 << (tp - SUV__QP_RAW8);
+            if (left < sz)
+            {
+                return -1;
+            }
+            switch (tp)
+            {
+            case SUV__QP_RAW8:
+                n = **pt;
+                break;
+            case SUV__QP_RAW16:
+                {
+                    uint16_t v;
+                    memcpy(&v, *pt, sizeof(uint16_t));
+                    n = v;
+                }
+                break;
+            case SUV__QP_RAW32:
+                {
+                    uint32_t v;
+                    memcpy(&v, *pt, sizeof(uint32_t));
+                    n = v;
+                }
+                break;
+            default:
+                {
+                    uint64_t v;
+                    memcpy(&v, *pt, sizeof(uint64_t));
+                    n = (v > SIZE_MAX) ? SIZE_MAX : (size_t) v;
+                }
+            }
+            *pt += sz;
+            left -= sz;
+        }
+
+        if (left < n || s == NULL)
+        {
+            return -1;
+        }
+        *s = (const char *) *pt;
+        *len = n;
+        *pt += n;
+        return SIRIDB_SERIES_TP_STR;
+    }
+
+    return -1;
+}
+
+/*
+ * Skip a value of any type. Returns 0 if successful or -1 if the data is
+ * invalid.
+ */
+static int suv__select_skip(
+    const unsigned char ** pt,
+    const unsigned char * end)
+{
+    int64_t i;
+    double d;
+    const char * s;
+    size_t n, len;
+    uint8_t close;
+
+    if (*pt == end)
+    {
+        return -1;
+    }
+
+    switch (**pt)
+    {
+    case SUV__QP_TRUE:
+    case SUV__QP_FALSE:
+    case SUV__QP_NULL:
+        (*pt)++;
+        return 0;
+    case SUV__QP_ARRAY_OPEN:
+        close = SUV__QP_ARRAY_CLOSE;
+        break;
+    case SUV__QP_MAP_OPEN:
+        close = SUV__QP_MAP_CLOSE;
+        break;
+    default:
+        if (**pt >= SUV__QP_ARRAY0 && **pt < SUV__QP_MAP0 + 6)
+        {
+            close = 0;
+            break;
+        }
+        return (suv__select_value(pt, end, &i, &d, &s, &len) < 0) ? -1 : 0;
+    }
+
+    if (close)
+    {
+        n = SUV__SELECT_OPEN;
+    }
+    else if (**pt < SUV__QP_MAP0)
+    {
+        n = **pt - SUV__QP_ARRAY0;
+    }
+    else
+    {
+        n = (**pt - SUV__QP_MAP0) * 2;
+    }
+    (*pt)++;
+
+    while (suv__select_next(pt, end, &n, close))
+    {
+        if (suv__select_skip(pt, end))
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * suv_select.h - Decode select results into columnar arrays.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_SELECT_H_
+#define SUV_SELECT_H_
+
+#include <suv.h>
+
+/* type definitions */
+typedef struct suv_select_s suv_select_t;
+typedef struct suv_select_series_s suv_select_series_t;
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_select_t * suv_select_create(siridb_pkg_t * pkg, int * rc);
+void suv_select_destroy(suv_select_t * select);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_select_series_s
+{
+    siridb_series_tp tp;        /* readonly */
+    const char * name;          /* readonly, null terminated */
+    size_t n;                   /* readonly, number of points */
+    uint64_t * ts;              /* readonly, n timestamps */
+    union
+    {
+        int64_t * int64;        /* SIRIDB_SERIES_TP_INT64 */
+        double * real;          /* SIRIDB_SERIES_TP_REAL */
+        char ** str;            /* SIRIDB_SERIES_TP_STR */
+    } via;                      /* readonly, n values */
+};
+
+struct suv_select_s
+{
+    void * data;                /* public */
+    size_t n;                   /* readonly, number of series */
+    suv_select_series_t * series;
+};
+
+#endif /* SUV_SELECT_H_ */
@@ -0,0 +1,547 @@
+/*
+ * suv_shm.c - Local ingest agent using shared memory rings.
+ *
+ *  The agent creates a POSIX shared memory object with a number of rings.
+ *  A producer process claims a free ring by writing its pid as owner, so
+ *  each ring has a single producer and a single consumer (the agent) and no
+ *  locks are needed: the producer only moves the head and the agent only
+ *  moves the tail. Adding a point is a copy into the ring.
+ *
+ *  The agent drains all rings on a timer and feeds the points to an ingest
+ *  object, which groups the points per series and sends them over the
+ *  connections of the ingest object. Rings of producers which exit without
+ *  suv_shm_close() are reclaimed by the agent.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_shm.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+#define SUV__SHM_RECORD_SZ 24
+#define SUV__SHM_PAD 0xff
+#define SUV__SHM_ALIGN(sz__) (((sz__) + 7) & ~((size_t) 7))
+#define SUV__SHM_RECLAIM 1000           /* milliseconds */
+
+struct suv__shm_hdr_s
+{
+    _Atomic uint32_t magic;     /* set when the rings are initialized */
+    uint32_t version;
+    uint32_t nrings;
+    uint32_t ring_size;         /* power of 2 */
+    char _pad[48];
+};
+
+struct suv__shm_ring_s
+{
+    _Atomic int32_t owner;      /* pid of the producer or 0 */
+    char _pad0[60];
+    _Atomic uint64_t head;      /* written by the producer */
+    char _pad1[56];
+    _Atomic uint64_t tail;      /* written by the agent */
+    char _pad2[56];
+    _Atomic uint64_t dropped;
+    char _pad3[56];
+    unsigned char data[];
+};
+
+typedef struct
+{
+    uint32_t size;              /* record size including the name */
+    uint16_t len;               /* name length */
+    uint8_t tp;                 /* siridb_series_tp or SUV__SHM_PAD */
+    uint8_t _pad;
+    uint64_t ts;
+    union
+    {
+        int64_t int64;
+        double real;
+    } via;
+} suv__shm_rec_t;
+
+static int suv__shm_add(
+    suv_shm_t * shm,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    siridb_series_tp tp,
+    const void * val);
+static suv__shm_ring_t * suv__shm_ring(
+    suv__shm_hdr_t * hdr,
+    size_t ring_size,
+    size_t i);
+static void suv__shm_timer_cb(uv_timer_t * handle);
+static void suv__shm_drain(suv_shm_agent_t * agent);
+static void suv__shm_close_cb(uv_handle_t * handle);
+
+/*
+ * Open the shared memory object of an agent and claim a ring. Returns a
+ * producer object or NULL in which case rc is set to ERR_MEM_ALLOC,
+ * ERR_OCCUPIED when all rings are in use, or a (positive) libuv error code.
+ * A producer object is not thread safe; use one object per thread.
+ */
+suv_shm_t * suv_shm_open(const char * name, int * rc)
+{
+    suv_shm_t * shm;
+    struct stat st;
+    void * addr;
+    size_t i;
+    int fd;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd == -1)
+    {
+        *rc = -uv_translate_sys_error(errno);
+        return NULL;
+    }
+
+    if (fstat(fd, &st) == -1 || (size_t) st.st_size < sizeof(suv__shm_hdr_t))
+    {
+        *rc = -UV_EINVAL;
+        close(fd);
+        return NULL;
+    }
+
+    addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        *rc = -uv_translate_sys_error(errno);
+        return NULL;
+    }
+
+    suv__shm_hdr_t * hdr = (suv__shm_hdr_t *) addr;
+    uint32_t magic = atomic_load_explicit(&hdr->magic, memory_order_acquire);
+    size_t nrings = hdr->nrings;
+    size_t ring_size = hdr->ring_size;
+
+    if (magic != SUV_SHM_MAGIC ||
+        hdr->version != SUV_SHM_VERSION ||
+        ring_size < 64 ||
+        (ring_size & (ring_size - 1)) ||
+        sizeof(suv__shm_hdr_t) + nrings *
+            (sizeof(suv__shm_ring_t) + ring_size) > (size_t) st.st_size)
+    {
+        *rc = -UV_EINVAL;
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+
+    shm = (suv_shm_t *) malloc(sizeof(suv_shm_t));
+    if (shm == NULL)
+    {
+        *rc = ERR_MEM_ALLOC;
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+
+    shm->data = NULL;
+    shm->n_points = 0;
+    shm->n_dropped = 0;
+    shm->_hdr = hdr;
+    shm->_ring = NULL;
+    shm->_size = st.st_size;
+    shm->_ring_size = ring_size;
+
+    for (i = 0; i < nrings; i++)
+    {
+        suv__shm_ring_t * ring = suv__shm_ring(hdr, ring_size, i);
+        int32_t owner = 0;
+        if (atomic_compare_exchange_strong(
+                &ring->owner,
+                &owner,
+                (int32_t) getpid()))
+        {
+            shm->_ring = ring;
+            break;
+        }
+    }
+
+    if (shm->_ring == NULL)
+    {
+        *rc = ERR_OCCUPIED;
+        suv_shm_close(shm);
+        return NULL;
+    }
+
+    *rc = 0;
+    return shm;
+}
+
+/*
+ * Release the ring and close a producer object. Points which are added are
+ * still sent by the agent.
+ */
+void suv_shm_close(suv_shm_t * shm)
+{
+    if (shm->_ring != NULL)
+    {
+        atomic_store_explicit(&shm->_ring->owner, 0, memory_order_release);
+    }
+    munmap(shm->_hdr, shm->_size);
+    free(shm);
+}
+
+/*
+ * Add an integer point. Returns 0 if successful or ERR_OCCUPIED when the
+ * point is dropped because the ring is full.
+ */
+int suv_shm_add_int64(
+    suv_shm_t * shm,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    int64_t val)
+{
+    return suv__shm_add(shm, name, len, ts, SIRIDB_SERIES_TP_INT64, &val);
+}
+
+/*
+ * Add a float point. Returns 0 if successful or ERR_OCCUPIED when the point
+ * is dropped because the ring is full.
+ */
+int suv_shm_add_real(
+    suv_shm_t * shm,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    double val)
+{
+    return suv__shm_add(shm, name, len, ts, SIRIDB_SERIES_TP_REAL, &val);
+}
+
+/*
+ * Create the shared memory object and return an agent object, or NULL in
+ * which case rc is set to ERR_MEM_ALLOC or a (positive) libuv error code.
+ * An existing object with the same name is replaced. The ring size is
+ * rounded up to a power of 2 and at most 2 GB. The ring layout is kept by
+ * the agent and never read back from the shared object. Points are sent
+ * using the ingest object.
+ */
+suv_shm_agent_t * suv_shm_agent_create(
+    uv_loop_t * loop,
+    const char * name,
+    suv_ingest_t * ingest,
+    size_t nrings,
+    size_t ring_size,
+    int * rc)
+{
+    suv_shm_agent_t * agent;
+    size_t sz = 64;
+    void * addr;
+    int fd;
+
+    if (nrings == 0 || nrings > UINT32_MAX || ring_size > UINT32_MAX / 2)
+    {
+        *rc = -UV_EINVAL;
+        return NULL;
+    }
+
+    while (sz < ring_size)
+    {
+        sz <<= 1;
+    }
+    ring_size = sz;
+    sz = sizeof(suv__shm_hdr_t) + nrings * (sizeof(suv__shm_ring_t) + sz);
+
+    agent = (suv_shm_agent_t *) malloc(sizeof(suv_shm_agent_t));
+    if (agent == NULL || (agent->_name = strdup(name)) == NULL)
+    {
+        free(agent);
+        *rc = ERR_MEM_ALLOC;
+        return NULL;
+    }
+
+    /* producers which still use a previous object keep their mapping */
+    shm_unlink(name);
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1 || ftruncate(fd, sz) == -1 ||
+        (addr = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) ==
+            MAP_FAILED)
+    {
+        *rc = -uv_translate_sys_error(errno);
+        if (fd != -1)
+        {
+            close(fd);
+            shm_unlink(name);
+        }
+        free(agent->_name);
+        free(agent);
+        return NULL;
+    }
+    close(fd);
+
+    /* the object is zero filled, so all rings are free and empty */
+    agent->_hdr = (suv__shm_hdr_t *) addr;
+    agent->_hdr->version = SUV_SHM_VERSION;
+    agent->_hdr->nrings = (uint32_t) nrings;
+    agent->_hdr->ring_size = (uint32_t) ring_size;
+    atomic_store_explicit(
+        &agent->_hdr->magic,
+        SUV_SHM_MAGIC,
+        memory_order_release);
+
+    agent->data = NULL;
+    agent->interval = SUV_SHM_INTERVAL;
+    agent->n_points = 0;
+    agent->n_invalid = 0;
+    agent->_ingest = ingest;
+    agent->_size = sz;
+    agent->_nrings = nrings;
+    agent->_ring_size = ring_size;
+    agent->_reclaim = 0;
+    agent->_cb = NULL;
+    agent->_closing = 0;
+
+    uv_timer_init(loop, &agent->_timer);
+    agent->_timer.data = (void *) agent;
+
+    *rc = 0;
+    return agent;
+}
+
+/*
+ * Start draining the rings every interval milliseconds. Returns 0 if
+ * successful or a libuv error code.
+ */
+int suv_shm_agent_start(suv_shm_agent_t * agent)
+{
+    return uv_timer_start(
+        &agent->_timer,
+        suv__shm_timer_cb,
+        agent->interval,
+        agent->interval);
+}
+
+/*
+ * Drain the rings a last time, flush the ingest object and remove the
+ * shared memory object. The agent is destroyed when the timer is closed,
+ * after which the optional callback is called. Wait for the pending ingest
+ * packages before destroying the ingest object.
+ */
+void suv_shm_agent_close(suv_shm_agent_t * agent, suv_shm_agent_cb cb)
+{
+    assert (!agent->_closing);  /* close is already called */
+
+    agent->_cb = cb;
+    agent->_closing = 1;
+
+    uv_timer_stop(&agent->_timer);
+    suv__shm_drain(agent);
+
+    atomic_store_explicit(&agent->_hdr->magic, 0, memory_order_release);
+    shm_unlink(agent->_name);
+    uv_close((uv_handle_t *) &agent->_timer, suv__shm_close_cb);
+}
+
+static int suv__shm_add(
+    suv_shm_t * shm,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    siridb_series_tp tp,
+    const void * val)
+{
+    suv__shm_ring_t * ring = shm->_ring;
+    size_t size = shm->_ring_size;
+    size_t need = SUV__SHM_ALIGN(SUV__SHM_RECORD_SZ + len);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t offset = (size_t) (head & (size - 1));
+    size_t contig = size - offset;
+    size_t total = need + ((contig < need) ? contig : 0);
+    suv__shm_rec_t * rec;
+
+    if (len > UINT16_MAX || need > size / 2 || head + total - tail > size)
+    {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        shm->n_dropped++;
+        return ERR_OCCUPIED;
+    }
+
+    if (contig < need)
+    {
+        /* skip the end of the ring so the record is not split */
+        rec = (suv__shm_rec_t *) (ring->data + offset);
+        rec->size = (uint32_t) contig;
+        rec->tp = SUV__SHM_PAD;
+        offset = 0;
+    }
+
+    rec = (suv__shm_rec_t *) (ring->data + offset);
+    rec->size = (uint32_t) need;
+    rec->len = (uint16_t) len;
+    rec->tp = (uint8_t) tp;
+    rec->ts = ts;
+    memcpy(&rec->via, val, sizeof(rec->via));
+    memcpy((char *) rec + SUV__SHM_RECORD_SZ, name, len);
+
+    atomic_store_explicit(&ring->head, head + total, memory_order_release);
+    shm->n_points++;
+    return 0;
+}
+
+/*
+ * Return ring i. The ring size is never read from the shared header since a
+ * producer may change it at any time.
+ */
+static suv__shm_ring_t * suv__shm_ring(
+    suv__shm_hdr_t * hdr,
+    size_t ring_size,
+    size_t i)
+{
+    return (suv__shm_ring_t *) ((char *) hdr + sizeof(suv__shm_hdr_t) +
+        i * (sizeof(suv__shm_ring_t) + ring_size));
+}
+
+static void suv__shm_timer_cb(uv_timer_t * handle)
+{
+    suv_shm_agent_t * agent = (suv_shm_agent_t *) handle->data;
+    uint64_t now = uv_now(handle->loop);
+
+    suv__shm_drain(agent);
+
+    if (now - agent->_reclaim < SUV__SHM_RECLAIM)
+    {
+        return;
+    }
+    agent->_reclaim = now;
+
+    /* free the rings of producers which did not close their ring */
+    for (size_t i = 0; i < agent->_nrings; i++)
+    {
+        suv__shm_ring_t * ring = suv__shm_ring(
+                agent->_hdr,
+                agent->_ring_size,
+                i);
+        int32_t owner = atomic_load_explicit(
+                &ring->owner,
+                memory_order_relaxed);
+        if (owner && kill((pid_t) owner, 0) == -1 && errno == ESRCH)
+        {
+            atomic_compare_exchange_strong(&ring->owner, &owner, 0);
+        }
+    }
+}
+
+/*
+ * Read all points from the rings into the ingest object and flush. Stops
+ * when the ingest object has max_pending packages in flight; the points
+ * wait in the rings until the next interval.
+ */
+static void suv__shm_drain(suv_shm_agent_t * agent)
+{
+    suv_ingest_t * ingest = agent->_ingest;
+    size_t size = agent->_ring_size;
+    uint64_t n = agent->n_points;
+
+    for (size_t i = 0; i < agent->_nrings; i++)
+    {
+        suv__shm_ring_t * ring = suv__shm_ring(agent->_hdr, size, i);
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        if (ingest->_pending >= ingest->max_pending)
+        {
+            break;
+        }
+
+        if (head - tail > size)
+        {
+            tail = head;  /* invalid head, skip the ring content */
+            agent->n_invalid++;
+        }
+
+        while (tail < head)
+        {
+            size_t offset = (size_t) (tail & (size - 1));
+            suv__shm_rec_t * rec = (suv__shm_rec_t *) (ring->data + offset);
+            uint64_t n_points = ingest->n_points;
+            int rc = 0;
+
+            if (rec->size < 8 ||
+                rec->size & 7 ||
+                rec->size > head - tail ||
+                rec->size > size - offset ||
+                (rec->tp != SUV__SHM_PAD &&
+                 (rec->size < SUV__SHM_RECORD_SZ ||
+                  rec->len > rec->size - SUV__SHM_RECORD_SZ)))
+            {
+                tail = head;  /* invalid record, skip the ring content */
+                agent->n_invalid++;
+                break;
+            }
+
+            if (rec->tp == SIRIDB_SERIES_TP_INT64)
+            {
+                rc = suv_ingest_add_int64(
+                    ingest,
+                    (const char *) rec + SUV__SHM_RECORD_SZ,
+                    rec->len,
+                    rec->ts,
+                    rec->via.int64);
+            }
+            else if (rec->tp == SIRIDB_SERIES_TP_REAL)
+            {
+                rc = suv_ingest_add_real(
+                    ingest,
+                    (const char *) rec + SUV__SHM_RECORD_SZ,
+                    rec->len,
+                    rec->ts,
+                    rec->via.real);
+            }
+            else if (rec->tp != SUV__SHM_PAD)
+            {
+                rc = 1;
+            }
+
+            if (rc < 0 && ingest->n_points == n_points)
+            {
+                break;  /* allocation error, retry next interval */
+            }
+
+            if (rec->tp != SUV__SHM_PAD)
+            {
+                agent->n_points++;
+                agent->n_invalid += (rc == 1);
+            }
+            tail += rec->size;
+
+            if (rc < 0)
+            {
+                /* the point is added but the flush failed; the points are
+                 * kept by the ingest object and flushed below */
+                break;
+            }
+        }
+
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    if (agent->n_points != n)
+    {
+        (void) suv_ingest_flush(ingest);
+    }
+}
+
+static void suv__shm_close_cb(uv_handle_t * handle)
+{
+    suv_shm_agent_t * agent = (suv_shm_agent_t *) handle->data;
+
+    munmap(agent->_hdr, agent->_size);
+    free(agent->_name);
+
+    if (agent->_cb != NULL)
+    {
+        agent->_cb(agent);
+    }
+    free(agent);
+}
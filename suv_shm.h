@@ -0,0 +1,92 @@
+/*
+ * suv_shm.h - Local ingest agent using shared memory rings.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_SHM_H_
+#define SUV_SHM_H_
+
+#include <suv.h>
+#include <suv_ingest.h>
+
+#define SUV_SHM_MAGIC 0x53565553        /* "SUVS" */
+#define SUV_SHM_VERSION 1
+#define SUV_SHM_RINGS 64
+#define SUV_SHM_RING_SIZE 1048576
+#define SUV_SHM_INTERVAL 10             /* milliseconds */
+
+/* type definitions */
+typedef struct suv_shm_s suv_shm_t;
+typedef struct suv_shm_agent_s suv_shm_agent_t;
+typedef struct suv__shm_hdr_s suv__shm_hdr_t;
+typedef struct suv__shm_ring_s suv__shm_ring_t;
+typedef void (*suv_shm_agent_cb) (suv_shm_agent_t * agent);
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* producer */
+suv_shm_t * suv_shm_open(const char * name, int * rc);
+void suv_shm_close(suv_shm_t * shm);
+int suv_shm_add_int64(
+    suv_shm_t * shm,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    int64_t val);
+int suv_shm_add_real(
+    suv_shm_t * shm,
+    const char * name,
+    size_t len,
+    uint64_t ts,
+    double val);
+
+/* agent */
+suv_shm_agent_t * suv_shm_agent_create(
+    uv_loop_t * loop,
+    const char * name,
+    suv_ingest_t * ingest,
+    size_t nrings,
+    size_t ring_size,
+    int * rc);
+int suv_shm_agent_start(suv_shm_agent_t * agent);
+void suv_shm_agent_close(suv_shm_agent_t * agent, suv_shm_agent_cb cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_shm_s
+{
+    void * data;                /* public */
+    uint64_t n_points;          /* readonly */
+    uint64_t n_dropped;         /* readonly, points dropped by a full ring */
+    suv__shm_hdr_t * _hdr;
+    suv__shm_ring_t * _ring;
+    size_t _size;
+    size_t _ring_size;
+};
+
+struct suv_shm_agent_s
+{
+    void * data;                /* public */
+    uint64_t interval;          /* public, milliseconds */
+    uint64_t n_points;          /* readonly */
+    uint64_t n_invalid;         /* readonly, skipped points and records */
+    uv_timer_t _timer;
+    suv_ingest_t * _ingest;
+    suv__shm_hdr_t * _hdr;
+    size_t _size;
+    size_t _nrings;
+    size_t _ring_size;
+    char * _name;
+    uint64_t _reclaim;
+    suv_shm_agent_cb _cb;
+    int _closing;
+};
+
+#endif /* SUV_SHM_H_ */
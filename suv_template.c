@@ -0,0 +1,236 @@
+/*
+ * suv_template.c - Insert templates for a repeated set of series.
+ *
+ *  A template holds a fixed set of series. The series names are encoded
+ *  once when the template is created; each insert only packs the points
+ *  which are filled in by the caller. The package buffer of an insert is
+ *  returned to the template when the insert is destroyed, so the next
+ *  insert can be packed without an allocation.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_template.h"
+#include "suv_qp.h"
+#include <string.h>
+#include <assert.h>
+
+/* array header + per point 1 array, 9 timestamp and 9 value bytes */
+#define SUV__TEMPLATE_SERIES_SZ(n__) (2 + (n__) * 19)
+
+/*
+ * Create and return a template or NULL in case of an allocation error or
+ * when a series type is not SIRIDB_SERIES_TP_INT64 or SIRIDB_SERIES_TP_REAL.
+ * Each series has room for max_points points.
+ */
+suv_template_t * suv_template_create(
+    const char * names[],
+    const siridb_series_tp tps[],
+    size_t n,
+    size_t max_points)
+{
+    suv__qp_t qp = {NULL, 0, 0};
+    suv_template_t * tpl;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (tps[i] != SIRIDB_SERIES_TP_INT64 &&
+            tps[i] != SIRIDB_SERIES_TP_REAL)
+        {
+            return NULL;
+        }
+    }
+
+    tpl = (suv_template_t *) malloc(sizeof(suv_template_t));
+    if (tpl == NULL)
+    {
+        return NULL;
+    }
+
+    tpl->data = NULL;
+    tpl->n = n;
+    tpl->max_points = max_points;
+    tpl->_buf = NULL;
+    tpl->_size = 0;
+    tpl->_names = NULL;
+    tpl->series = (suv_template_series_t *) malloc(
+            sizeof(suv_template_series_t) * (n ? n : 1));
+    tpl->_points = (uint64_t *) malloc(
+            sizeof(uint64_t) * 2 * ((n && max_points) ? n * max_points : 1));
+
+    if (tpl->series == NULL || tpl->_points == NULL)
+    {
+        suv_template_destroy(tpl);
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        suv_template_series_t * series = tpl->series + i;
+        size_t len = strlen(names[i]);
+
+        series->_offset = qp.len;
+        if (suv__qp_add_raw(&qp, names[i], len) || suv__qp_reserve(&qp, 1))
+        {
+            free(qp.data);
+            suv_template_destroy(tpl);
+            return NULL;
+        }
+        series->_len = qp.len - series->_offset;
+
+        /* keep a terminated copy of the name after the encoded name */
+        qp.data[qp.len++] = '\0';
+
+        series->tp = tps[i];
+        series->n = 0;
+        series->ts = tpl->_points + i * max_points;
+        series->via.int64 = (int64_t *) (tpl->_points + (n + i) * max_points);
+    }
+
+    tpl->_names = qp.data;
+
+    /* names are set when the encoded names are not moved anymore */
+    for (i = 0; i < n; i++)
+    {
+        suv_template_series_t * series = tpl->series + i;
+        series->name = (const char *) tpl->_names +
+                series->_offset + series->_len - strlen(names[i]);
+    }
+
+    return tpl;
+}
+
+/*
+ * Destroy a template. Inserts which are created from the template do not
+ * depend on the template and can be destroyed using suv_insert_destroy().
+ */
+void suv_template_destroy(suv_template_t * tpl)
+{
+    free(tpl->series);
+    free(tpl->_points);
+    free(tpl->_names);
+    free(tpl->_buf);
+    free(tpl);
+}
+
+/*
+ * Create and return an insert object with the points of all series, or
+ * NULL in case of an allocation error. The number of points of a series
+ * may not exceed max_points. Series without points are not included. The
+ * number of points of each series is reset to 0 when successful.
+ *
+ * The insert should be destroyed using suv_template_insert_destroy() so the
+ * package buffer can be reused.
+ */
+suv_insert_t * suv_template_insert_create(
+    suv_template_t * tpl,
+    siridb_req_t * req)
+{
+    suv__qp_t qp = {tpl->_buf, 0, tpl->_size};
+    suv_insert_t * insert;
+    size_t i, nseries = 0, sz = sizeof(siridb_pkg_t) + 2;
+
+    for (i = 0; i < tpl->n; i++)
+    {
+        suv_template_series_t * series = tpl->series + i;
+        assert (series->n <= tpl->max_points);
+        if (series->n)
+        {
+            nseries++;
+            sz += series->_len + SUV__TEMPLATE_SERIES_SZ(series->n);
+        }
+    }
+
+    /* reserve the size of the complete package at once */
+    if (suv__qp_reserve(&qp, sz))
+    {
+        return NULL;
+    }
+    tpl->_buf = qp.data;
+    tpl->_size = qp.size;
+
+    qp.len = sizeof(siridb_pkg_t);
+    int close_map = suv__qp_add_map(&qp, nseries);
+
+    for (i = 0; i < tpl->n; i++)
+    {
+        suv_template_series_t * series = tpl->series + i;
+        uint64_t * ts = series->ts;
+        uint64_t * end = ts + series->n;
+
+        if (ts == end)
+        {
+            continue;
+        }
+
+        memcpy(qp.data + qp.len, tpl->_names + series->_offset, series->_len);
+        qp.len += series->_len;
+
+        int close_arr = suv__qp_add_array(&qp, series->n);
+
+        if (series->tp == SIRIDB_SERIES_TP_INT64)
+        {
+            int64_t * val = series->via.int64;
+            for (; ts < end; ts++, val++)
+            {
+                suv__qp_add_type(&qp, SUV__QP_ARRAY0 + 2);
+                suv__qp_add_int64(&qp, (int64_t) *ts);
+                suv__qp_add_int64(&qp, *val);
+            }
+        }
+        else
+        {
+            double * val = series->via.real;
+            for (; ts < end; ts++, val++)
+            {
+                suv__qp_add_type(&qp, SUV__QP_ARRAY0 + 2);
+                suv__qp_add_int64(&qp, (int64_t) *ts);
+                suv__qp_add_double(&qp, *val);
+            }
+        }
+
+        if (close_arr)
+        {
+            suv__qp_add_type(&qp, SUV__QP_ARRAY_CLOSE);
+        }
+    }
+
+    if (close_map)
+    {
+        suv__qp_add_type(&qp, SUV__QP_MAP_CLOSE);
+    }
+
+    insert = suv_write_create(req, suv__qp_to_pkg(&qp, CprotoReqInsert));
+    if (insert == NULL)
+    {
+        return NULL;
+    }
+
+    /* the buffer is owned by the insert until it is destroyed */
+    tpl->_buf = NULL;
+    tpl->_size = 0;
+
+    for (i = 0; i < tpl->n; i++)
+    {
+        tpl->series[i].n = 0;
+    }
+
+    return insert;
+}
+
+/*
+ * Destroy an insert object and keep its package buffer for the next insert.
+ */
+void suv_template_insert_destroy(
+    suv_template_t * tpl,
+    suv_insert_t * insert)
+{
+    if (tpl->_buf == NULL)
+    {
+        tpl->_buf = (unsigned char *) insert->pkg;
+        tpl->_size = sizeof(siridb_pkg_t) + insert->pkg->len;
+        insert->pkg = NULL;
+    }
+    suv_insert_destroy(insert);
+}
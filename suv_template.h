@@ -0,0 +1,66 @@
+/*
+ * suv_template.h - Insert templates for a repeated set of series.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_TEMPLATE_H_
+#define SUV_TEMPLATE_H_
+
+#include <suv.h>
+
+/* type definitions */
+typedef struct suv_template_s suv_template_t;
+typedef struct suv_template_series_s suv_template_series_t;
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_template_t * suv_template_create(
+    const char * names[],
+    const siridb_series_tp tps[],
+    size_t n,
+    size_t max_points);
+void suv_template_destroy(suv_template_t * tpl);
+suv_insert_t * suv_template_insert_create(
+    suv_template_t * tpl,
+    siridb_req_t * req);
+void suv_template_insert_destroy(
+    suv_template_t * tpl,
+    suv_insert_t * insert);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_template_series_s
+{
+    const char * name;          /* readonly */
+    siridb_series_tp tp;        /* readonly */
+    size_t n;                   /* public, number of points to insert */
+    uint64_t * ts;              /* readonly, room for max_points */
+    union
+    {
+        int64_t * int64;        /* SIRIDB_SERIES_TP_INT64 */
+        double * real;          /* SIRIDB_SERIES_TP_REAL */
+    } via;                      /* readonly, room for max_points */
+    size_t _offset;             /* encoded name */
+    size_t _len;
+};
+
+struct suv_template_s
+{
+    void * data;                /* public */
+    size_t n;                   /* readonly, number of series */
+    size_t max_points;          /* readonly, points per series */
+    suv_template_series_t * series;
+    uint64_t * _points;         /* timestamps and values of all series */
+    unsigned char * _names;     /* qpack encoded names */
+    unsigned char * _buf;       /* package buffer for reuse */
+    size_t _size;
+};
+
+#endif /* SUV_TEMPLATE_H_ */
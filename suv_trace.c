@@ -0,0 +1,200 @@
+/*
+ * suv_trace.c - Per request lifecycle tracing.
+ *
+ *  Events are stored in a fixed size ring buffer. A trace object is not
+ *  thread safe so use one trace object per loop; it may be shared by all
+ *  connections on that loop. When suv_buf_t.trace is NULL (the default)
+ *  tracing costs a single pointer check per event.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_trace.h"
+#include <inttypes.h>
+
+static const char * suv__trace_phase[] = {
+    "queued",       /* SUV_TRACE_CREATE .. SUV_TRACE_WRITE */
+    "write",        /* SUV_TRACE_WRITE .. SUV_TRACE_WRITE_DONE */
+    "server",       /* SUV_TRACE_WRITE_DONE .. SUV_TRACE_RECV_FIRST */
+    "receive",      /* SUV_TRACE_RECV_FIRST .. SUV_TRACE_RECV_LAST */
+    "callback"      /* SUV_TRACE_RECV_LAST .. SUV_TRACE_CB_DONE */
+};
+
+typedef struct
+{
+    const suv_buf_t * buf;      /* NULL for an unused slot */
+    uint16_t pid;
+    uint8_t open;               /* begin event is written */
+    uint8_t ev;                 /* last event, begins the open phase */
+} suv__trace_req_t;
+
+static suv__trace_req_t * suv__trace_req(
+    suv__trace_req_t * reqs,
+    size_t mask,
+    const suv_trace_rec_t * rec);
+static int suv__trace_event(
+    FILE * fp,
+    int * first,
+    const suv_trace_rec_t * rec,
+    const char * name,
+    char ph);
+
+/*
+ * Create and return a trace object or NULL in case of an allocation error.
+ * The size is rounded up to a power of two and is the number of events the
+ * ring buffer can hold. Set suv_buf_t.trace to trace a connection.
+ */
+suv_trace_t * suv_trace_create(size_t size)
+{
+    size_t sz = 1;
+    while (sz < size)
+    {
+        sz <<= 1;
+    }
+
+    suv_trace_t * trace = (suv_trace_t *) malloc(sizeof(suv_trace_t));
+    if (trace != NULL)
+    {
+        trace->data = NULL;
+        trace->n = 0;
+        trace->_mask = sz - 1;
+        trace->_recs = (suv_trace_rec_t *) malloc(sizeof(suv_trace_rec_t) * sz);
+        if (trace->_recs == NULL)
+        {
+            free(trace);
+            trace = NULL;
+        }
+    }
+    return trace;
+}
+
+/*
+ * Destroy a trace object. Make sure no connection uses the trace anymore.
+ */
+void suv_trace_destroy(suv_trace_t * trace)
+{
+    free(trace->_recs);
+    free(trace);
+}
+
+/*
+ * Write the events in the ring buffer as Chrome trace JSON which can be
+ * loaded in chrome://tracing or Perfetto. Each request is an async event
+ * with nested phases. A request which fails or is cancelled skips phases, so
+ * an event ends the phase which was begun by the previous event of the same
+ * request. Events of a request whose create event is not in the ring buffer
+ * (anymore) are skipped. Returns 0 if successful or -1 in case
+ * of a write or allocation error.
+ */
+int suv_trace_dump(suv_trace_t * trace, FILE * fp)
+{
+    size_t size = trace->_mask + 1;
+    size_t mask = size * 2 - 1;
+    uint64_t i = (trace->n > size) ? trace->n - size : 0;
+    suv__trace_req_t * reqs;
+    int first = 1;
+    int rc = -1;
+
+    /* at most one slot per event so this table is never more than half full */
+    reqs = (suv__trace_req_t *) calloc(mask + 1, sizeof(suv__trace_req_t));
+    if (reqs == NULL)
+    {
+        return -1;
+    }
+
+    if (fputs("{\"traceEvents\":[", fp) < 0)
+    {
+        goto done;
+    }
+
+    for (; i < trace->n; i++)
+    {
+        const suv_trace_rec_t * rec = trace->_recs + (i & trace->_mask);
+        suv__trace_req_t * req = suv__trace_req(reqs, mask, rec);
+
+        if (rec->ev == SUV_TRACE_CREATE)
+        {
+            if (suv__trace_event(fp, &first, rec, "request", 'b'))
+            {
+                goto done;
+            }
+            req->open = 1;
+        }
+        else if (!req->open)
+        {
+            continue;  /* begin of the request is not seen */
+        }
+        else if (suv__trace_event(
+                fp, &first, rec, suv__trace_phase[req->ev], 'e'))
+        {
+            goto done;
+        }
+        req->ev = rec->ev;
+
+        if (rec->ev != SUV_TRACE_CB_DONE && suv__trace_event(
+                fp, &first, rec, suv__trace_phase[rec->ev], 'b'))
+        {
+            goto done;
+        }
+
+        if (rec->ev == SUV_TRACE_CB_DONE)
+        {
+            if (suv__trace_event(fp, &first, rec, "request", 'e'))
+            {
+                goto done;
+            }
+            req->open = 0;
+        }
+    }
+
+    rc = (fputs("]}\n", fp) < 0) ? -1 : 0;
+
+done:
+    free(reqs);
+    return rc;
+}
+
+/*
+ * Return the slot for the request of an event. Slots are never removed.
+ */
+static suv__trace_req_t * suv__trace_req(
+    suv__trace_req_t * reqs,
+    size_t mask,
+    const suv_trace_rec_t * rec)
+{
+    size_t i = (((uintptr_t) rec->buf >> 4) * 31 + rec->pid) & mask;
+
+    for (; reqs[i].buf != NULL; i = (i + 1) & mask)
+    {
+        if (reqs[i].buf == rec->buf && reqs[i].pid == rec->pid)
+        {
+            return reqs + i;
+        }
+    }
+
+    reqs[i].buf = rec->buf;
+    reqs[i].pid = rec->pid;
+    return reqs + i;
+}
+
+static int suv__trace_event(
+    FILE * fp,
+    int * first,
+    const suv_trace_rec_t * rec,
+    const char * name,
+    char ph)
+{
+    int rc = fprintf(
+        fp,
+        "%s{\"name\":\"%s\",\"cat\":\"suv\",\"ph\":\"%c\","
+        "\"id\":\"%p:%u\",\"ts\":%" PRIu64 ".%03u,\"pid\":1,\"tid\":1}",
+        *first ? "" : ",\n",
+        name,
+        ph,
+        (const void *) rec->buf,
+        rec->pid,
+        rec->ts / 1000,
+        (unsigned int) (rec->ts % 1000));
+    *first = 0;
+    return (rc < 0) ? -1 : 0;
+}
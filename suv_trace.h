@@ -0,0 +1,74 @@
+/*
+ * suv_trace.h - Per request lifecycle tracing.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_TRACE_H_
+#define SUV_TRACE_H_
+
+#include <stdio.h>
+#include <suv.h>
+
+/* type definitions */
+typedef enum
+{
+    SUV_TRACE_CREATE,       /* write object is created */
+    SUV_TRACE_WRITE,        /* write is submitted to libuv */
+    SUV_TRACE_WRITE_DONE,   /* libuv has written the package */
+    SUV_TRACE_RECV_FIRST,   /* first byte of the response is received */
+    SUV_TRACE_RECV_LAST,    /* last byte of the response is received */
+    SUV_TRACE_CB_DONE       /* request callback has returned */
+} suv_trace_ev_t;
+
+typedef struct suv_trace_rec_s suv_trace_rec_t;
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_trace_t * suv_trace_create(size_t size);
+void suv_trace_destroy(suv_trace_t * trace);
+int suv_trace_dump(suv_trace_t * trace, FILE * fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* struct definitions */
+struct suv_trace_rec_s
+{
+    uint64_t ts;                /* uv_hrtime() in nanoseconds */
+    const suv_buf_t * buf;      /* connection */
+    uint16_t pid;
+    uint8_t ev;                 /* suv_trace_ev_t */
+};
+
+struct suv_trace_s
+{
+    void * data;                /* public */
+    uint64_t n;                 /* readonly, total number of events */
+    size_t _mask;
+    suv_trace_rec_t * _recs;
+};
+
+/*
+ * Add an event to the ring buffer, the oldest event is overwritten when
+ * the ring buffer is full.
+ */
+static inline void suv_trace_add(
+    suv_trace_t * trace,
+    const suv_buf_t * buf,
+    uint16_t pid,
+    suv_trace_ev_t ev,
+    uint64_t ts)
+{
+    suv_trace_rec_t * rec = trace->_recs + (trace->n++ & trace->_mask);
+    rec->ts = ts;
+    rec->buf = buf;
+    rec->pid = pid;
+    rec->ev = (uint8_t) ev;
+}
+
+#endif /* SUV_TRACE_H_ */
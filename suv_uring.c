@@ -0,0 +1,701 @@
+/*
+ * suv_uring.c - Optional io_uring transport for SiriDB connections.
+ *
+ *  One ring is used per loop. The ring file descriptor is watched by a
+ *  uv_poll_t so completions are handled by the libuv loop, and submissions
+ *  are collected and made with a single system call from a prepare handle,
+ *  once per loop iteration.
+ *
+ *  Each connection has one multishot receive which picks a buffer from a
+ *  provided buffer ring, so no system call is needed per read. Packages are
+ *  copied to a send buffer of the connection; while a send is in flight the
+ *  next packages are collected in a second buffer. Since the kernel never
+ *  references a package, a request can be cancelled at any time.
+ *
+ *  The connection is still a libuv TCP handle, only its reads and writes
+ *  are made through the ring.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "suv_uring.h"
+
+#ifdef SUV_USE_IO_URING
+
+#include <liburing.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#define SUV__URING_BGID 0
+
+typedef enum
+{
+    SUV__URING_RECV,
+    SUV__URING_SEND
+} suv__uring_tp_t;
+
+typedef struct
+{
+    suv__uring_tp_t tp;
+    suv__uring_conn_t * conn;
+} suv__uring_op_t;
+
+typedef struct
+{
+    suv__uring_op_t op;
+    char * data;
+    size_t len;
+    size_t size;
+    size_t done;                /* bytes sent */
+    uint16_t * pids;
+    size_t n;
+    size_t npids;
+} suv__uring_send_t;
+
+struct suv__uring_conn_s
+{
+    suv_uring_t * uring;
+    suv_buf_t * suvbf;          /* NULL when the connection is stopped */
+    int fd;
+    size_t ref;                 /* connection, dirty list and operations */
+    suv__uring_read_cb read_cb;
+    suv__uring_sent_cb sent_cb;
+    suv__uring_op_t recv;
+    suv__uring_send_t send[2];
+    int cur;                    /* send buffer which collects packages */
+    int sending;
+    int recving;
+    int dirty;
+    suv__uring_conn_t * next;   /* next in the dirty list */
+};
+
+static struct io_uring_sqe * suv__uring_sqe(suv_uring_t * uring);
+static void suv__uring_cancel(suv_uring_t * uring, suv__uring_op_t * op);
+static int suv__uring_recv(suv__uring_conn_t * conn);
+static int suv__uring_send(suv__uring_conn_t * conn, suv__uring_send_t * send);
+static void suv__uring_recv_cqe(suv__uring_conn_t * conn, int res, int flags);
+static void suv__uring_send_cqe(
+    suv__uring_conn_t * conn,
+    suv__uring_send_t * send,
+    int res);
+static void suv__uring_unref(suv__uring_conn_t * conn);
+static void suv__uring_poll_cb(uv_poll_t * handle, int status, int events);
+static void suv__uring_prepare_cb(uv_prepare_t * handle);
+static void suv__uring_destroy(suv_uring_t * uring);
+static void suv__uring_close_cb(uv_handle_t * handle);
+
+/*
+ * Create and return an io_uring transport or NULL in which case rc is set
+ * to ERR_MEM_ALLOC or a (positive) libuv error code. Set suv_buf_t.uring
+ * before suv_connect() to use the transport for a connection. It may be
+ * shared by all connections on the same loop.
+ */
+suv_uring_t * suv_uring_create(uv_loop_t * loop, int * rc)
+{
+    struct io_uring * ring;
+    int err;
+
+    suv_uring_t * uring = (suv_uring_t *) malloc(sizeof(suv_uring_t));
+    ring = (struct io_uring *) malloc(sizeof(struct io_uring));
+    if (uring == NULL || ring == NULL)
+    {
+        free(uring);
+        free(ring);
+        *rc = ERR_MEM_ALLOC;
+        return NULL;
+    }
+
+    uring->data = NULL;
+    uring->entries = SUV_URING_ENTRIES;
+    uring->n_bufs = SUV_URING_NBUFS;
+    uring->buf_size = SUV_URING_BUF_SIZE;
+    uring->n_submits = 0;
+    uring->n_cqes = 0;
+    uring->_ring = (void *) ring;
+    uring->_br = NULL;
+    uring->_dirty = NULL;
+    uring->_nconn = 0;
+    uring->_nhandles = 0;
+    uring->_cb = NULL;
+    uring->_closing = 0;
+
+    err = io_uring_queue_init(uring->entries, ring, 0);
+    if (err)
+    {
+        free(ring);
+        free(uring);
+        *rc = -err;
+        return NULL;
+    }
+
+    uring->_bufs = (char *) malloc(uring->n_bufs * uring->buf_size);
+    if (uring->_bufs == NULL)
+    {
+        err = -ENOMEM;
+        goto failed;
+    }
+
+    uring->_br = (void *) io_uring_setup_buf_ring(
+            ring,
+            uring->n_bufs,
+            SUV__URING_BGID,
+            0,
+            &err);
+    if (uring->_br == NULL)
+    {
+        goto failed;
+    }
+
+    for (unsigned int i = 0; i < uring->n_bufs; i++)
+    {
+        io_uring_buf_ring_add(
+            (struct io_uring_buf_ring *) uring->_br,
+            uring->_bufs + i * uring->buf_size,
+            uring->buf_size,
+            i,
+            io_uring_buf_ring_mask(uring->n_bufs),
+            i);
+    }
+    io_uring_buf_ring_advance(
+        (struct io_uring_buf_ring *) uring->_br,
+        uring->n_bufs);
+
+    err = uv_poll_init(loop, &uring->_poll, ring->ring_fd);
+    if (err)
+    {
+        goto failed;
+    }
+    uring->_poll.data = (void *) uring;
+    uv_poll_start(&uring->_poll, UV_READABLE, suv__uring_poll_cb);
+
+    uv_prepare_init(loop, &uring->_prepare);
+    uring->_prepare.data = (void *) uring;
+
+    *rc = 0;
+    return uring;
+
+failed:
+    if (uring->_br != NULL)
+    {
+        io_uring_free_buf_ring(
+            ring,
+            (struct io_uring_buf_ring *) uring->_br,
+            uring->n_bufs,
+            SUV__URING_BGID);
+    }
+    io_uring_queue_exit(ring);
+    free(uring->_bufs);
+    free(ring);
+    free(uring);
+    *rc = (err == -ENOMEM) ? ERR_MEM_ALLOC : -err;
+    return NULL;
+}
+
+/*
+ * Close the transport when all connections using it are closed. The
+ * callback (which may be NULL) is called after which the transport is
+ * destroyed.
+ */
+void suv_uring_close(suv_uring_t * uring, suv_uring_cb cb)
+{
+    assert (!uring->_closing);  /* close is already called */
+
+    uring->_cb = cb;
+    uring->_closing = 1;
+
+    if (uring->_nconn == 0)
+    {
+        suv__uring_destroy(uring);
+    }
+}
+
+/*
+ * Start reading a connection through the ring. Returns a connection or NULL
+ * in which case rc is set to ERR_MEM_ALLOC or a (positive) libuv error code.
+ */
+suv__uring_conn_t * suv__uring_start(
+    suv_uring_t * uring,
+    suv_buf_t * suvbf,
+    uv_os_fd_t fd,
+    suv__uring_read_cb read_cb,
+    suv__uring_sent_cb sent_cb,
+    int * rc)
+{
+    suv__uring_conn_t * conn;
+
+    if (uring->_closing)
+    {
+        *rc = -UV_EINVAL;
+        return NULL;
+    }
+
+    conn = (suv__uring_conn_t *) calloc(1, sizeof(suv__uring_conn_t));
+    if (conn == NULL)
+    {
+        *rc = ERR_MEM_ALLOC;
+        return NULL;
+    }
+
+    conn->uring = uring;
+    conn->suvbf = suvbf;
+    conn->fd = fd;
+    conn->ref = 1;
+    conn->read_cb = read_cb;
+    conn->sent_cb = sent_cb;
+    conn->recv.tp = SUV__URING_RECV;
+    conn->recv.conn = conn;
+    for (int i = 0; i < 2; i++)
+    {
+        conn->send[i].op.tp = SUV__URING_SEND;
+        conn->send[i].op.conn = conn;
+    }
+
+    uring->_nconn++;
+
+    *rc = suv__uring_recv(conn);
+    if (*rc)
+    {
+        suv__uring_unref(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+/*
+ * Copy a package to the send buffer of a connection. The package is sent
+ * from the prepare handle. Returns 0 if successful or ERR_MEM_ALLOC.
+ */
+int suv__uring_write(suv__uring_conn_t * conn, siridb_pkg_t * pkg)
+{
+    suv__uring_send_t * send = conn->send + conn->cur;
+    size_t sz = sizeof(siridb_pkg_t) + pkg->len;
+    suv_uring_t * uring = conn->uring;
+
+    if (send->len + sz > send->size)
+    {
+        size_t size = send->size ? send->size * 2 : uring->buf_size;
+        char * tmp;
+        while (size < send->len + sz)
+        {
+            size *= 2;
+        }
+        tmp = (char *) realloc(send->data, size);
+        if (tmp == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+        send->data = tmp;
+        send->size = size;
+    }
+
+    if (send->n == send->npids)
+    {
+        size_t npids = send->npids ? send->npids * 2 : 64;
+        uint16_t * tmp = (uint16_t *) realloc(
+                send->pids,
+                sizeof(uint16_t) * npids);
+        if (tmp == NULL)
+        {
+            return ERR_MEM_ALLOC;
+        }
+        send->pids = tmp;
+        send->npids = npids;
+    }
+
+    memcpy(send->data + send->len, pkg, sz);
+    send->len += sz;
+    send->pids[send->n++] = pkg->pid;
+
+    if (!conn->dirty)
+    {
+        conn->dirty = 1;
+        conn->ref++;
+        conn->next = uring->_dirty;
+        uring->_dirty = conn;
+        uv_prepare_start(&uring->_prepare, suv__uring_prepare_cb);
+    }
+    return 0;
+}
+
+/*
+ * Stop a connection, used before the TCP handle is closed. Callbacks are
+ * not called anymore. Packages which are not sent are dropped; the
+ * requests are cancelled when the TCP handle is closed.
+ */
+void suv__uring_stop(suv__uring_conn_t * conn)
+{
+    conn->suvbf = NULL;
+
+    if (conn->recving)
+    {
+        suv__uring_cancel(conn->uring, &conn->recv);
+    }
+
+    if (conn->sending)
+    {
+        /* the other buffer is collecting, see suv__uring_prepare_cb() */
+        suv__uring_cancel(conn->uring, &conn->send[conn->cur ^ 1].op);
+    }
+
+    suv__uring_unref(conn);
+}
+
+/*
+ * Cancel an operation. The operation is identified by its user data so the
+ * file descriptor may already be closed when the entry is submitted.
+ */
+static void suv__uring_cancel(suv_uring_t * uring, suv__uring_op_t * op)
+{
+    struct io_uring_sqe * sqe = suv__uring_sqe(uring);
+    if (sqe != NULL)
+    {
+        io_uring_prep_cancel64(sqe, (uintptr_t) op, 0);
+        io_uring_sqe_set_data(sqe, NULL);
+    }
+}
+
+/*
+ * Return a submission queue entry or NULL when the queue is full and cannot
+ * be submitted.
+ */
+static struct io_uring_sqe * suv__uring_sqe(suv_uring_t * uring)
+{
+    struct io_uring * ring = (struct io_uring *) uring->_ring;
+    struct io_uring_sqe * sqe = io_uring_get_sqe(ring);
+
+    if (sqe == NULL && io_uring_submit(ring) >= 0)
+    {
+        uring->n_submits++;
+        sqe = io_uring_get_sqe(ring);
+    }
+
+    if (sqe != NULL)
+    {
+        uv_prepare_start(&uring->_prepare, suv__uring_prepare_cb);
+    }
+    return sqe;
+}
+
+static int suv__uring_recv(suv__uring_conn_t * conn)
+{
+    struct io_uring_sqe * sqe = suv__uring_sqe(conn->uring);
+    if (sqe == NULL)
+    {
+        return -UV_EBUSY;
+    }
+
+    io_uring_prep_recv_multishot(sqe, conn->fd, NULL, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = SUV__URING_BGID;
+    io_uring_sqe_set_data(sqe, &conn->recv);
+
+    conn->recving = 1;
+    conn->ref++;
+    return 0;
+}
+
+static int suv__uring_send(suv__uring_conn_t * conn, suv__uring_send_t * send)
+{
+    struct io_uring_sqe * sqe = suv__uring_sqe(conn->uring);
+    if (sqe == NULL)
+    {
+        return -UV_EBUSY;
+    }
+
+    io_uring_prep_send(
+        sqe,
+        conn->fd,
+        send->data + send->done,
+        send->len - send->done,
+        MSG_NOSIGNAL);
+    io_uring_sqe_set_data(sqe, &send->op);
+
+    conn->sending = 1;
+    conn->ref++;
+    return 0;
+}
+
+static void suv__uring_recv_cqe(suv__uring_conn_t * conn, int res, int flags)
+{
+    suv_uring_t * uring = conn->uring;
+
+    if (flags & IORING_CQE_F_BUFFER)
+    {
+        unsigned int bid = (unsigned int) flags >> IORING_CQE_BUFFER_SHIFT;
+        char * buf = uring->_bufs + bid * uring->buf_size;
+
+        if (res > 0 && conn->suvbf != NULL)
+        {
+            conn->read_cb(conn->suvbf, buf, res);
+        }
+
+        /* the data is handled so the buffer can be used again */
+        io_uring_buf_ring_add(
+            (struct io_uring_buf_ring *) uring->_br,
+            buf,
+            uring->buf_size,
+            bid,
+            io_uring_buf_ring_mask(uring->n_bufs),
+            0);
+        io_uring_buf_ring_advance((struct io_uring_buf_ring *) uring->_br, 1);
+    }
+    else if (res == 0 && conn->suvbf != NULL)
+    {
+        conn->read_cb(conn->suvbf, NULL, UV_EOF);
+    }
+    else if (res < 0 &&
+             res != -ENOBUFS &&
+             res != -ECANCELED &&
+             conn->suvbf != NULL)
+    {
+        conn->read_cb(conn->suvbf, NULL, res);
+    }
+
+    if (!(flags & IORING_CQE_F_MORE))
+    {
+        /* the receive has ended, it is restarted when out of buffers */
+        conn->recving = 0;
+        if (conn->suvbf != NULL && (res > 0 || res == -ENOBUFS))
+        {
+            int rc = suv__uring_recv(conn);
+            if (rc)
+            {
+                conn->read_cb(conn->suvbf, NULL, -rc);
+            }
+        }
+        suv__uring_unref(conn);
+    }
+}
+
+static void suv__uring_send_cqe(
+    suv__uring_conn_t * conn,
+    suv__uring_send_t * send,
+    int res)
+{
+    int status = (res < 0) ? res : (res == 0) ? UV_EIO : 0;
+
+    conn->sending = 0;
+
+    if (res > 0 && send->done + (size_t) res < send->len)
+    {
+        /* short send, send the remaining bytes */
+        send->done += (size_t) res;
+        status = -suv__uring_send(conn, send);
+        if (status == 0)
+        {
+            suv__uring_unref(conn);
+            return;
+        }
+    }
+
+    /* a callback may write again or stop the connection */
+    for (size_t i = 0; i < send->n && conn->suvbf != NULL; i++)
+    {
+        conn->sent_cb(conn->suvbf, send->pids[i], status);
+    }
+
+    send->len = 0;
+    send->done = 0;
+    send->n = 0;
+
+    if (conn->suvbf != NULL)
+    {
+        suv__uring_send_t * next = conn->send + conn->cur;
+        if (next->len && suv__uring_send(conn, next) == 0)
+        {
+            conn->cur ^= 1;
+        }
+    }
+
+    suv__uring_unref(conn);
+}
+
+static void suv__uring_unref(suv__uring_conn_t * conn)
+{
+    suv_uring_t * uring = conn->uring;
+
+    if (--conn->ref)
+    {
+        return;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        free(conn->send[i].data);
+        free(conn->send[i].pids);
+    }
+    free(conn);
+
+    if (--uring->_nconn == 0 && uring->_closing)
+    {
+        suv__uring_destroy(uring);
+    }
+}
+
+static void suv__uring_poll_cb(uv_poll_t * handle, int status, int events)
+{
+    suv_uring_t * uring = (suv_uring_t *) handle->data;
+    struct io_uring * ring = (struct io_uring *) uring->_ring;
+    struct io_uring_cqe * cqe;
+    (void) status;
+    (void) events;
+
+    while (uring->_ring != NULL && io_uring_peek_cqe(ring, &cqe) == 0)
+    {
+        suv__uring_op_t * op = (suv__uring_op_t *) io_uring_cqe_get_data(cqe);
+        int res = cqe->res;
+        int flags = (int) cqe->flags;
+
+        /* the entry is released first since handling might submit */
+        io_uring_cqe_seen(ring, cqe);
+        uring->n_cqes++;
+
+        if (op == NULL)
+        {
+            continue;  /* cancel request */
+        }
+
+        if (op->tp == SUV__URING_RECV)
+        {
+            suv__uring_recv_cqe(op->conn, res, flags);
+        }
+        else
+        {
+            suv__uring_send_cqe(op->conn, (suv__uring_send_t *) op, res);
+        }
+    }
+}
+
+/*
+ * Runs once per loop iteration, just before the loop waits for I/O. Starts
+ * a send for each connection with packages and no send in flight, and
+ * submits all entries with a single system call.
+ */
+static void suv__uring_prepare_cb(uv_prepare_t * handle)
+{
+    suv_uring_t * uring = (suv_uring_t *) handle->data;
+    struct io_uring * ring = (struct io_uring *) uring->_ring;
+
+    uv_prepare_stop(handle);
+
+    while (uring->_dirty != NULL)
+    {
+        suv__uring_conn_t * conn = uring->_dirty;
+        uring->_dirty = conn->next;
+        conn->dirty = 0;
+
+        if (conn->suvbf != NULL && !conn->sending)
+        {
+            suv__uring_send_t * send = conn->send + conn->cur;
+            int rc = suv__uring_send(conn, send);
+            if (rc == 0)
+            {
+                conn->cur ^= 1;
+            }
+            else
+            {
+                for (size_t i = 0; i < send->n && conn->suvbf != NULL; i++)
+                {
+                    conn->sent_cb(conn->suvbf, send->pids[i], -rc);
+                }
+                send->len = 0;
+                send->n = 0;
+            }
+        }
+        suv__uring_unref(conn);
+    }
+
+    if (uring->_ring != NULL && io_uring_sq_ready(ring))
+    {
+        io_uring_submit(ring);
+        uring->n_submits++;
+    }
+}
+
+static void suv__uring_destroy(suv_uring_t * uring)
+{
+    struct io_uring * ring = (struct io_uring *) uring->_ring;
+
+    io_uring_free_buf_ring(
+        ring,
+        (struct io_uring_buf_ring *) uring->_br,
+        uring->n_bufs,
+        SUV__URING_BGID);
+    io_uring_queue_exit(ring);
+    free(ring);
+    free(uring->_bufs);
+    uring->_ring = NULL;
+
+    uring->_nhandles = 2;
+    uv_poll_stop(&uring->_poll);
+    uv_close((uv_handle_t *) &uring->_poll, suv__uring_close_cb);
+    uv_close((uv_handle_t *) &uring->_prepare, suv__uring_close_cb);
+}
+
+static void suv__uring_close_cb(uv_handle_t * handle)
+{
+    suv_uring_t * uring = (suv_uring_t *) handle->data;
+
+    if (--uring->_nhandles)
+    {
+        return;
+    }
+
+    if (uring->_cb != NULL)
+    {
+        uring->_cb(uring);
+    }
+    free(uring);
+}
+
+#else
+
+/*
+ * Without io_uring support the transport cannot be created.
+ */
+suv_uring_t * suv_uring_create(uv_loop_t * loop, int * rc)
+{
+    (void) loop;
+    *rc = -UV_ENOSYS;
+    return NULL;
+}
+
+void suv_uring_close(suv_uring_t * uring, suv_uring_cb cb)
+{
+    if (cb != NULL)
+    {
+        cb(uring);
+    }
+}
+
+suv__uring_conn_t * suv__uring_start(
+    suv_uring_t * uring,
+    suv_buf_t * suvbf,
+    uv_os_fd_t fd,
+    suv__uring_read_cb read_cb,
+    suv__uring_sent_cb sent_cb,
+    int * rc)
+{
+    (void) uring;
+    (void) suvbf;
+    (void) fd;
+    (void) read_cb;
+    (void) sent_cb;
+    *rc = -UV_ENOSYS;
+    return NULL;
+}
+
+int suv__uring_write(suv__uring_conn_t * conn, siridb_pkg_t * pkg)
+{
+    (void) conn;
+    (void) pkg;
+    return ERR_SOCK_WRITE;
+}
+
+void suv__uring_stop(suv__uring_conn_t * conn)
+{
+    (void) conn;
+}
+
+#endif /* SUV_USE_IO_URING */
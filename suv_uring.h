@@ -0,0 +1,78 @@
+/*
+ * suv_uring.h - Optional io_uring transport for SiriDB connections.
+ *
+ *  Only available on Linux when libsuv is compiled with SUV_USE_IO_URING
+ *  defined and linked with liburing. Otherwise suv_uring_create() fails
+ *  with UV_ENOSYS.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SUV_URING_H_
+#define SUV_URING_H_
+
+#include <suv.h>
+
+#define SUV_URING_ENTRIES 256
+#define SUV_URING_NBUFS 64
+#define SUV_URING_BUF_SIZE 65536
+
+/* type definitions */
+typedef void (*suv_uring_cb) (suv_uring_t * uring);
+
+/* private type definitions, used by suv.c */
+typedef struct suv__uring_conn_s suv__uring_conn_t;
+typedef void (*suv__uring_read_cb) (
+    suv_buf_t * suvbf,
+    const char * data,
+    ssize_t n);
+typedef void (*suv__uring_sent_cb) (
+    suv_buf_t * suvbf,
+    uint16_t pid,
+    int status);
+
+/* public functions */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+suv_uring_t * suv_uring_create(uv_loop_t * loop, int * rc);
+void suv_uring_close(suv_uring_t * uring, suv_uring_cb cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* private functions, used by suv.c */
+suv__uring_conn_t * suv__uring_start(
+    suv_uring_t * uring,
+    suv_buf_t * suvbf,
+    uv_os_fd_t fd,
+    suv__uring_read_cb read_cb,
+    suv__uring_sent_cb sent_cb,
+    int * rc);
+int suv__uring_write(suv__uring_conn_t * conn, siridb_pkg_t * pkg);
+void suv__uring_stop(suv__uring_conn_t * conn);
+
+/* struct definitions */
+struct suv_uring_s
+{
+    void * data;                /* public */
+    unsigned int entries;       /* readonly, submission queue size */
+    unsigned int n_bufs;        /* readonly, number of receive buffers */
+    size_t buf_size;            /* readonly, size of a receive buffer */
+    uint64_t n_submits;         /* readonly, submit system calls */
+    uint64_t n_cqes;            /* readonly, handled completions */
+    void * _ring;               /* struct io_uring */
+    void * _br;                 /* struct io_uring_buf_ring */
+    char * _bufs;
+    uv_poll_t _poll;
+    uv_prepare_t _prepare;
+    suv__uring_conn_t * _dirty; /* connections with packages to send */
+    size_t _nconn;
+    size_t _nhandles;
+    suv_uring_cb _cb;
+    int _closing;
+};
+
+#endif /* SUV_URING_H_ */
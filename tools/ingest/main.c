@@ -0,0 +1,242 @@
+/*
+ * main.c
+ *    Ingest CSV or Graphite plaintext from a file or stdin into SiriDB.
+ *
+ *  Usage:
+ *
+ *     suv-ingest [-c] [-H host] [-P port] [-u user] [-p password]
+ *                [-d dbname] [-n connections] [-m max-points]
+ *                [-t s|ms|us|ns] [file]
+ *
+ *     Each line is '<name> <value> <timestamp>' (Graphite plaintext), or
+ *     '<name>,<timestamp>,<value>' when -c is used. Without a file, data is
+ *     read from stdin. Graphite timestamps are in seconds and are converted
+ *     to the time precision given with -t. (default s)
+ *
+ *  Compile using:
+ *
+ *     gcc main.c -lsuv -lsiridb -lqpack -luv -o suv-ingest
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <suv.h>
+#include <suv_ingest.h>
+
+#define MAX_CONNECTIONS 64
+
+static uv_loop_t loop;
+static suv_buf_t * bufs[MAX_CONNECTIONS];
+static size_t nbufs = 1;
+static size_t nhandled = 0;
+static int exit_code = 0;
+static uv_file infd = 0;
+static suv_ingest_t * ingest = NULL;
+static uint64_t start;
+
+static void connect_cb(siridb_req_t * req);
+static void ingest_cb(suv_ingest_t * ingest, int status);
+static void close_all(void);
+
+int main(int argc, char * argv[])
+{
+    const char * host = "127.0.0.1";
+    const char * user = "iris";
+    const char * passwd = "siri";
+    const char * dbname = "dbtest";
+    int port = 9000;
+    int csv = 0;
+    size_t max_points = 0;
+    uint64_t ts_multiplier = 1;
+    struct sockaddr_in addr;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "cH:P:u:p:d:n:m:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c': csv = 1; break;
+        case 'H': host = optarg; break;
+        case 'P': port = atoi(optarg); break;
+        case 'u': user = optarg; break;
+        case 'p': passwd = optarg; break;
+        case 'd': dbname = optarg; break;
+        case 'n': nbufs = (size_t) atoi(optarg); break;
+        case 'm': max_points = (size_t) atoi(optarg); break;
+        case 't':
+            ts_multiplier =
+                (strcmp(optarg, "s") == 0) ? 1 :
+                (strcmp(optarg, "ms") == 0) ? 1000 :
+                (strcmp(optarg, "us") == 0) ? 1000000 :
+                (strcmp(optarg, "ns") == 0) ? 1000000000 : 0;
+            if (ts_multiplier)
+            {
+                break;
+            }
+            /* fall through */
+        default:
+            fprintf(stderr,
+                "usage: %s [-c] [-H host] [-P port] [-u user] [-p password] "
+                "[-d dbname] [-n connections] [-m max-points] "
+                "[-t s|ms|us|ns] [file]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    if (nbufs == 0 || nbufs > MAX_CONNECTIONS)
+    {
+        fprintf(stderr, "connections must be between 1 and %d\n",
+                MAX_CONNECTIONS);
+        return 1;
+    }
+
+    if (optind < argc && (infd = open(argv[optind], O_RDONLY)) < 0)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    uv_loop_init(&loop);
+    uv_ip4_addr(host, port, &addr);
+
+    for (size_t i = 0; i < nbufs; i++)
+    {
+        siridb_t * siridb = siridb_create();
+        bufs[i] = (siridb == NULL) ? NULL : suv_buf_create(siridb);
+        if (bufs[i] == NULL)
+        {
+            fprintf(stderr, "memory allocation error\n");
+            return 1;
+        }
+
+        siridb_req_t * req = siridb_req_create(siridb, connect_cb, NULL);
+        suv_connect_t * connect = suv_connect_create(req, user, passwd, dbname);
+        if (connect == NULL)
+        {
+            fprintf(stderr, "memory allocation error\n");
+            return 1;
+        }
+        req->data = (void *) connect;
+        suv_connect(&loop, connect, bufs[i], (struct sockaddr *) &addr);
+    }
+
+    ingest = suv_ingest_create(bufs, nbufs);
+    if (ingest == NULL)
+    {
+        fprintf(stderr, "memory allocation error\n");
+        return 1;
+    }
+    ingest->fmt = csv ? SUV_INGEST_FMT_CSV : SUV_INGEST_FMT_GRAPHITE;
+    ingest->ts_multiplier = ts_multiplier;
+    if (max_points)
+    {
+        ingest->max_points = max_points;
+    }
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    for (size_t i = 0; i < nbufs; i++)
+    {
+        siridb_t * siridb = bufs[i]->siridb;
+        suv_buf_destroy(bufs[i]);
+        siridb_destroy(siridb);
+    }
+
+    suv_ingest_destroy(ingest);
+    uv_loop_close(&loop);
+
+    if (infd > 0)
+    {
+        close(infd);
+    }
+
+    return exit_code;
+}
+
+static void connect_cb(siridb_req_t * req)
+{
+    suv_connect_t * connect = (suv_connect_t *) req->data;
+
+    nhandled++;
+
+    if (req->status)
+    {
+        fprintf(stderr, "connect failed: %s\n", suv_strerror(req->status));
+        exit_code = 1;
+    }
+    else if (req->pkg->tp != CprotoResAuthSuccess)
+    {
+        fprintf(stderr, "auth failed (error %u)\n", req->pkg->tp);
+        exit_code = 1;
+    }
+
+    suv_connect_destroy(connect);
+    siridb_req_destroy(req);
+
+    if (nhandled < nbufs)
+    {
+        return;
+    }
+
+    if (exit_code)
+    {
+        close_all();
+        return;
+    }
+
+    start = uv_hrtime();
+
+    int rc = suv_ingest_fd(ingest, &loop, infd, ingest_cb);
+    if (rc)
+    {
+        fprintf(stderr, "cannot read input: %s\n", suv_strerror(rc));
+        exit_code = 1;
+        close_all();
+    }
+}
+
+static void ingest_cb(suv_ingest_t * ingest, int status)
+{
+    double sec = (double) (uv_hrtime() - start) / 1e9;
+
+    if (status)
+    {
+        fprintf(stderr, "ingest failed: %s\n", suv_strerror(status));
+        exit_code = 1;
+    }
+
+    printf(
+        "lines: %" PRIu64 " (invalid: %" PRIu64 ")\n"
+        "points: %" PRIu64 "\n"
+        "packages: %" PRIu64 " (failed: %" PRIu64 ")\n"
+        "time: %.3f seconds (%.0f points/second)\n",
+        ingest->n_lines,
+        ingest->n_invalid,
+        ingest->n_points,
+        ingest->n_packages,
+        ingest->n_failed,
+        sec,
+        sec > 0.0 ? (double) ingest->n_points / sec : 0.0);
+
+    if (ingest->n_failed)
+    {
+        exit_code = 1;
+    }
+
+    close_all();
+}
+
+static void close_all(void)
+{
+    for (size_t i = 0; i < nbufs; i++)
+    {
+        suv_close(bufs[i], NULL);
+    }
+}
@@ -0,0 +1,358 @@
+/*
+ * main.c
+ *    Replay the requests from a libsuv capture file against SiriDB and report
+ *    the throughput and latency.
+ *
+ *  Usage:
+ *
+ *     suv-replay [-s speed] [-n max-pending] [-H host] [-P port] [-u user]
+ *                [-p password] [-d dbname] file
+ *
+ *     With speed 1 (default) requests are sent at the original pace, with
+ *     speed N at N times the original pace and with speed 0 as fast as
+ *     possible while keeping at most max-pending requests in flight.
+ *     Captured authentication requests are skipped; the replay uses its own
+ *     connection and credentials.
+ *
+ *  Compile using:
+ *
+ *     gcc main.c -lsuv -lsiridb -lqpack -luv -o suv-replay
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <suv.h>
+#include <suv_capture.h>
+
+typedef struct
+{
+    uint64_t ts;
+    const unsigned char * pkg;
+    size_t size;
+} record_t;
+
+static uv_loop_t loop;
+static uv_timer_t timer;
+static suv_buf_t * buf;
+static record_t * records;
+static uint64_t * latencies;
+static uint64_t * sent;
+static size_t nrecords = 0;
+static size_t next = 0;
+static size_t ndone = 0;
+static size_t nerrors = 0;
+static size_t pending = 0;
+static size_t max_pending = 256;
+static size_t nbytes = 0;
+static double speed = 1.0;
+static uint64_t start;
+static int exit_code = 0;
+
+static unsigned char * read_file(const char * fn, size_t * len);
+static void connect_cb(siridb_req_t * req);
+static void replay_cb(siridb_req_t * req);
+static void timer_cb(uv_timer_t * handle);
+static void schedule(void);
+static void send_record(size_t i);
+static void report(void);
+static int cmp_uint64(const void * a, const void * b);
+
+int main(int argc, char * argv[])
+{
+    const char * host = "127.0.0.1";
+    const char * user = "iris";
+    const char * passwd = "siri";
+    const char * dbname = "dbtest";
+    int port = 9000;
+    struct sockaddr_in addr;
+    suv_capture_rec_t rec;
+    unsigned char * data;
+    size_t len, offset = 0;
+    int opt, rc;
+
+    while ((opt = getopt(argc, argv, "s:n:H:P:u:p:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': speed = atof(optarg); break;
+        case 'n': max_pending = (size_t) atoi(optarg); break;
+        case 'H': host = optarg; break;
+        case 'P': port = atoi(optarg); break;
+        case 'u': user = optarg; break;
+        case 'p': passwd = optarg; break;
+        case 'd': dbname = optarg; break;
+        default:
+            optind = argc;
+        }
+    }
+
+    if (optind != argc - 1 || speed < 0.0 || max_pending == 0)
+    {
+        fprintf(stderr,
+            "usage: %s [-s speed] [-n max-pending] [-H host] [-P port] "
+            "[-u user] [-p password] [-d dbname] file\n",
+            argv[0]);
+        return 1;
+    }
+
+    if ((data = read_file(argv[optind], &len)) == NULL)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    records = (record_t *) malloc(sizeof(record_t) * (len / 17 + 1));
+    if (records == NULL)
+    {
+        fprintf(stderr, "memory allocation error\n");
+        return 1;
+    }
+
+    while ((rc = suv_capture_next(data, len, &offset, &rec)) == 0)
+    {
+        if (rec.dir == SUV_CAPTURE_OUT && rec.tp != CprotoReqAuth)
+        {
+            records[nrecords].ts = rec.ts;
+            records[nrecords].pkg = rec.pkg;
+            records[nrecords].size = rec.size;
+            nrecords++;
+        }
+    }
+
+    if (rc < 0)
+    {
+        fprintf(stderr, "invalid capture file: %s\n", argv[optind]);
+        return 1;
+    }
+
+    if (nrecords == 0)
+    {
+        printf("no requests found in %s\n", argv[optind]);
+        return 0;
+    }
+
+    latencies = (uint64_t *) malloc(sizeof(uint64_t) * nrecords);
+    sent = (uint64_t *) malloc(sizeof(uint64_t) * nrecords);
+    if (latencies == NULL || sent == NULL)
+    {
+        fprintf(stderr, "memory allocation error\n");
+        return 1;
+    }
+
+    uv_loop_init(&loop);
+    uv_timer_init(&loop, &timer);
+    uv_ip4_addr(host, port, &addr);
+
+    siridb_t * siridb = siridb_create();
+    buf = suv_buf_create(siridb);
+    siridb_req_t * req = siridb_req_create(siridb, connect_cb, NULL);
+    suv_connect_t * connect = suv_connect_create(req, user, passwd, dbname);
+    if (connect == NULL)
+    {
+        fprintf(stderr, "memory allocation error\n");
+        return 1;
+    }
+    req->data = (void *) connect;
+    suv_connect(&loop, connect, buf, (struct sockaddr *) &addr);
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    suv_buf_destroy(buf);
+    siridb_destroy(siridb);
+    uv_loop_close(&loop);
+
+    free(sent);
+    free(latencies);
+    free(records);
+    free(data);
+
+    return exit_code;
+}
+
+static unsigned char * read_file(const char * fn, size_t * len)
+{
+    unsigned char * data;
+    long sz;
+    FILE * fp = fopen(fn, "rb");
+    if (fp == NULL)
+    {
+        return NULL;
+    }
+
+    if (fseek(fp, 0, SEEK_END) || (sz = ftell(fp)) < 0)
+    {
+        fclose(fp);
+        return NULL;
+    }
+    rewind(fp);
+
+    data = (unsigned char *) malloc(sz ? sz : 1);
+    if (data != NULL && fread(data, 1, sz, fp) != (size_t) sz)
+    {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(fp);
+    *len = (size_t) sz;
+    return data;
+}
+
+static void connect_cb(siridb_req_t * req)
+{
+    suv_connect_t * connect = (suv_connect_t *) req->data;
+
+    if (req->status)
+    {
+        fprintf(stderr, "connect failed: %s\n", suv_strerror(req->status));
+        exit_code = 1;
+    }
+    else if (req->pkg->tp != CprotoResAuthSuccess)
+    {
+        fprintf(stderr, "auth failed (error %u)\n", req->pkg->tp);
+        exit_code = 1;
+    }
+
+    suv_connect_destroy(connect);
+    siridb_req_destroy(req);
+
+    if (exit_code)
+    {
+        uv_close((uv_handle_t *) &timer, NULL);
+        suv_close(buf, NULL);
+        return;
+    }
+
+    start = uv_hrtime();
+    schedule();
+}
+
+/*
+ * Send all requests which are due and start the timer for the next one.
+ */
+static void schedule(void)
+{
+    uint64_t now = uv_hrtime();
+
+    while (next < nrecords)
+    {
+        if (speed > 0.0)
+        {
+            uint64_t due = start + (uint64_t) (
+                (double) (records[next].ts - records[0].ts) / speed);
+            if (due > now)
+            {
+                uv_timer_start(&timer, timer_cb, (due - now) / 1000000, 0);
+                return;
+            }
+        }
+        else if (pending >= max_pending)
+        {
+            return;
+        }
+        send_record(next++);
+    }
+}
+
+static void timer_cb(uv_timer_t * handle)
+{
+    (void) handle;
+    schedule();
+}
+
+static void send_record(size_t i)
+{
+    siridb_req_t * req;
+    siridb_pkg_t * pkg;
+    suv_write_t * swrite;
+
+    req = siridb_req_create(buf->siridb, replay_cb, NULL);
+    pkg = (req == NULL) ? NULL : (siridb_pkg_t *) malloc(records[i].size);
+    if (pkg != NULL)
+    {
+        memcpy(pkg, records[i].pkg, records[i].size);
+    }
+
+    /* suv_write_create() sets the package id to the new request pid */
+    swrite = (pkg == NULL) ? NULL : suv_write_create(req, pkg);
+    if (swrite == NULL)
+    {
+        fprintf(stderr, "memory allocation error\n");
+        abort();
+    }
+
+    swrite->data = (void *) &sent[i];
+    req->data = (void *) swrite;
+
+    pending++;
+    nbytes += records[i].size;
+    sent[i] = uv_hrtime();
+
+    suv_write(swrite);
+}
+
+static void replay_cb(siridb_req_t * req)
+{
+    suv_write_t * swrite = (suv_write_t *) req->data;
+    uint64_t * ts = (uint64_t *) swrite->data;
+
+    if (req->status || req->pkg->tp >= CprotoErrMsg)
+    {
+        nerrors++;
+    }
+
+    latencies[ndone++] = uv_hrtime() - *ts;
+    pending--;
+
+    suv_write_destroy(swrite);
+    siridb_req_destroy(req);
+
+    if (ndone == nrecords)
+    {
+        report();
+        uv_close((uv_handle_t *) &timer, NULL);
+        suv_close(buf, NULL);
+    }
+    else if (speed == 0.0)
+    {
+        schedule();
+    }
+}
+
+static void report(void)
+{
+    double sec = (double) (uv_hrtime() - start) / 1e9;
+    double total = 0.0;
+
+    qsort(latencies, ndone, sizeof(uint64_t), cmp_uint64);
+    for (size_t i = 0; i < ndone; i++)
+    {
+        total += (double) latencies[i];
+    }
+
+    printf(
+        "requests: %zu (errors: %zu)\n"
+        "time: %.3f seconds\n"
+        "throughput: %.0f requests/second, %.2f MB/second\n"
+        "latency (ms): avg %.3f, p50 %.3f, p99 %.3f, max %.3f\n",
+        ndone,
+        nerrors,
+        sec,
+        sec > 0.0 ? (double) ndone / sec : 0.0,
+        sec > 0.0 ? (double) nbytes / sec / 1e6 : 0.0,
+        total / ndone / 1e6,
+        (double) latencies[ndone / 2] / 1e6,
+        (double) latencies[(ndone * 99) / 100] / 1e6,
+        (double) latencies[ndone - 1] / 1e6);
+}
+
+static int cmp_uint64(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}